@@ -0,0 +1,324 @@
+#ifndef EM_RINGBUF_BROADCAST_CPP_H
+#define EM_RINGBUF_BROADCAST_CPP_H
+
+#include "RingBufLock.h"
+
+/**
+ * A ring buffer with one producer and several independent readers, each of
+ * which receives every element, e.g. to fan the same events out to a logger
+ * and a control loop. The elements are stored once, every reader only has
+ * its own read cursor (a free-running sequence number of the next element
+ * to read), so an additional reader costs 8 bytes instead of a copy of the
+ * buffer.
+ *
+ * A full buffer can be handled in two ways, chosen per call:
+ * - `add()` applies backpressure, it fails while the slowest reader has
+ *   not read the oldest element yet.
+ * - `addOverwrite()` always succeeds, overwriting the oldest element. A
+ *   reader which fell behind skips the overwritten elements on its next
+ *   read and counts them, see `lost()`.
+ *
+ * Every reader must only be used by one context at a time.
+ *
+ * @tparam Type        Type of the elements being stored, must be trivially
+ *                     copyable.
+ * @tparam MaxElements Maximum number of elements in this buffer.
+ * @tparam Readers     Number of readers, indexed from 0.
+ * @tparam LockPolicy  Protection of the critical sections, see RingBufLock.h.
+ */
+template<typename Type, size_t MaxElements, size_t Readers, typename LockPolicy = RingBufAtomicLock>
+class RingBufBroadcast : protected LockPolicy {
+    static_assert(RB_IS_TRIVIALLY_COPYABLE(Type), "Type must be trivially copyable");
+    static_assert(MaxElements > 0, "MaxElements must be at least 1");
+    static_assert(Readers > 0, "At least one reader is required");
+    static_assert(MaxElements < 0x80000000ul, "MaxElements does not fit in a sequence number");
+
+    typedef RingBufLockGuard<LockPolicy> Guard;
+
+public:
+
+    constexpr RingBufBroadcast() :
+            _buf(),
+            _cursors(),
+            _head(0),
+            _written(0) {
+    }
+
+    /**
+     * @return maximum number of elements in the buffer.
+     */
+    static constexpr size_t capacity() {
+        return MaxElements;
+    }
+
+
+    /**
+     *  Add an element to the buffer for all readers, unless the slowest
+     *  reader still has `MaxElements` elements to read.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        bool ret = false;
+
+        {
+            Guard guard(*this);
+
+            if (maxUnread() < MaxElements) {
+                write(obj);
+                ret = true;
+            }
+        }
+
+        return ret;
+    }
+
+
+    /**
+     *  Add an element to the buffer for all readers, overwriting the oldest
+     *  element if the buffer is full. The readers which did not read it yet
+     *  lose it.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true if the oldest element was overwritten before all readers
+     *          read it, false if there was room for the element.
+     */
+    bool addOverwrite(const Type &obj) {
+        bool ret;
+
+        {
+            Guard guard(*this);
+
+            ret = maxUnread() >= MaxElements;
+            write(obj);
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * Remove the oldest unread element of the reader, and copy it to
+     * destination. The element stays in the buffer for the other readers.
+     *
+     * @param reader    Index of the reader, less than `Readers`.
+     * @param dest[out] Pointer on the allocated object to which the element
+     *                  will be copied.
+     *
+     * @return true on success, false if the reader read all elements.
+     */
+    bool pull(size_t reader, Type *dest) {
+        bool ret = false;
+
+        {
+            Guard guard(*this);
+            Cursor &cursor = _cursors[reader];
+            size_t unread = catchUp(cursor);
+
+            if (unread) {
+                *dest = _buf[Index::add(_head, MaxElements - unread)];
+                cursor.next++;
+
+                ret = true;
+            }
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * Remove multiple oldest unread elements of the reader and copy them to
+     * destination, in at most two contiguous blocks within a single critical
+     * section.
+     *
+     * @param reader    Index of the reader, less than `Readers`.
+     * @param dest[out] Array to which the elements will be copied.
+     * @param num       Maximum number of elements to copy, `dest` must be
+     *                  large enough to hold this many elements.
+     *
+     * @return number of elements copied, less than `num` if the reader read
+     *         all elements.
+     */
+    size_t pullMany(size_t reader, Type *dest, size_t num) {
+        {
+            Guard guard(*this);
+            Cursor &cursor = _cursors[reader];
+            size_t unread = catchUp(cursor);
+
+            if (num > unread)
+                num = unread;
+
+            size_t start = Index::add(_head, MaxElements - unread);
+            size_t first = MaxElements - start;
+            if (first > num)
+                first = num;
+
+            Copy::copy(dest, &_buf[start], first);
+            Copy::copy(dest + first, _buf, num - first);
+            cursor.next += (Sequence) num;
+        }
+
+        return num;
+    }
+
+
+    /**
+     * @param reader Index of the reader, less than `Readers`.
+     *
+     * @return number of elements the reader did not read yet.
+     */
+    size_t numElements(size_t reader) const {
+        size_t ret;
+
+        {
+            Guard guard(*this);
+            Sequence unread = _written - _cursors[reader].next;
+
+            ret = (unread > MaxElements) ? MaxElements : unread;
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * @param reader Index of the reader, less than `Readers`.
+     *
+     * @return true if the reader read all elements.
+     */
+    bool isEmpty(size_t reader) const {
+        return !numElements(reader);
+    }
+
+
+    /**
+     * @return true if `add()` would fail because the slowest reader did not
+     *         read the oldest element yet.
+     */
+    bool isFull() const {
+        bool ret;
+
+        {
+            Guard guard(*this);
+            ret = maxUnread() >= MaxElements;
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * @param reader Index of the reader, less than `Readers`.
+     *
+     * @return number of elements overwritten by `addOverwrite()` before the
+     *         reader read them, since construction or `resetLost()`.
+     */
+    uint32_t lost(size_t reader) const {
+        uint32_t ret;
+
+        {
+            Guard guard(*this);
+            const Cursor &cursor = _cursors[reader];
+            Sequence unread = _written - cursor.next;
+
+            ret = cursor.lost;
+            if (unread > MaxElements)
+                ret += unread - (Sequence) MaxElements;
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * Reset the number of elements lost by the reader.
+     *
+     * @param reader Index of the reader, less than `Readers`.
+     */
+    void resetLost(size_t reader) {
+        {
+            Guard guard(*this);
+            Cursor &cursor = _cursors[reader];
+
+            catchUp(cursor);
+            cursor.lost = 0;
+        }
+    }
+
+protected:
+    typedef RingBufIndex<MaxElements> Index;
+    typedef RingBufCopy<Type> Copy;
+    typedef typename RingBufIndexType<MaxElements>::type IndexType;
+    /** Free-running number of elements written, wrapping around. */
+    typedef uint32_t Sequence;
+
+    struct Cursor {
+        /** Sequence number of the next element to read. */
+        Sequence next;
+        /** Number of elements overwritten before they were read. */
+        uint32_t lost;
+    };
+
+
+    /**
+     * Adds the element, must be called from within the critical section.
+     */
+    void write(const Type &obj) {
+        _buf[_head] = obj;
+        _head = Index::add(_head, 1);
+        _written++;
+    }
+
+
+    /**
+     * @return the largest number of elements a reader did not read yet, at
+     *         most `MaxElements`.
+     */
+    size_t maxUnread() const {
+        Sequence ret = 0;
+
+        for (size_t i = 0; i < Readers; i++) {
+            Sequence unread = _written - _cursors[i].next;
+            if (unread > ret)
+                ret = unread;
+        }
+
+        return (ret > MaxElements) ? MaxElements : ret;
+    }
+
+
+    /**
+     * Skips the elements which were overwritten before the reader read them
+     * and counts them as lost, must be called from within the critical
+     * section.
+     *
+     * @return number of elements the reader did not read yet.
+     */
+    size_t catchUp(Cursor &cursor) {
+        Sequence unread = _written - cursor.next;
+
+        if (unread > MaxElements) {
+            cursor.lost += unread - (Sequence) MaxElements;
+            cursor.next = _written - (Sequence) MaxElements;
+            unread = MaxElements;
+        }
+
+        return unread;
+    }
+
+
+    Type _buf[MaxElements];
+    Cursor _cursors[Readers];
+    /** Index of the next element to write. */
+    IndexType _head;
+    /** Sequence number of the next element to write. */
+    Sequence _written;
+private:
+
+};
+
+#endif
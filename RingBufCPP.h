@@ -2,31 +2,147 @@
 #define EM_RINGBUF_CPP_H
 
 #include "RingBufHelpers.h"
+#include "RingBufLock.h"
+
+/**
+ * Storage of RingBufCPP. The destructor is trivial for trivially
+ * destructible types, so that global buffers are constant-initialized (placed
+ * in `.bss` without any startup code), otherwise it destroys the elements
+ * remaining in the buffer.
+ */
+template<typename Type, size_t MaxElements, bool = RB_IS_TRIVIALLY_DESTRUCTIBLE(Type)>
+class RingBufStorage {
+public:
+
+    constexpr RingBufStorage() :
+            _none(),
+            _head(0),
+            _numElements(0),
+            _removed(0) {
+    }
+
+protected:
+    typedef typename RingBufIndexType<MaxElements>::type IndexType;
+
+    /**
+     * Underlying array, in a union so that its elements are not constructed
+     * together with the buffer.
+     */
+    union {
+        Type _buf[MaxElements];
+        /** Member initialized instead of the array. */
+        char _none;
+    };
+
+    /** Index of the next element to write. */
+    IndexType _head;
+    IndexType _numElements;
+    /**
+     * Total number of elements removed (wrapping around), used to detect
+     * elements being removed during `peekCopy()`.
+     */
+    size_t _removed;
+};
+
+
+template<typename Type, size_t MaxElements>
+class RingBufStorage<Type, MaxElements, false> {
+public:
+
+    constexpr RingBufStorage() :
+            _none(),
+            _head(0),
+            _numElements(0),
+            _removed(0) {
+    }
+
+    ~RingBufStorage() {
+        size_t index = RingBufIndex<MaxElements>::add(_head, MaxElements - _numElements);
+
+        for (size_t num = _numElements; num; num--) {
+            _buf[index].~Type();
+            index = RingBufIndex<MaxElements>::add(index, 1);
+        }
+    }
+
+protected:
+    typedef typename RingBufIndexType<MaxElements>::type IndexType;
+
+    union {
+        Type _buf[MaxElements];
+        char _none;
+    };
+
+    IndexType _head;
+    IndexType _numElements;
+    size_t _removed;
+};
+
 
 /**
  * A simple ring (FIFO) buffer with concurrency protection built in, thus being
  * safe to perform operations on the buffer inside of ISR's. All memory is
  * statically allocated at compile time, so no heap memory is used. It can
  * buffer any fixed size object (ints, floats, structs, objects, etc...).
+ * Elements are only constructed while they are in the buffer, they are
+ * destroyed when removed.
  *
  * @tparam Type        Type of the elements being stored.
  * @tparam MaxElements Maximum number of elements in this buffer. Note that
  *                     the allocated memory size will be at least
  *                     `MaxElements * sizeof(Type)`.
+ * @tparam LockPolicy  Protection of the critical sections, see RingBufLock.h.
+ *                     The default masks interrupts like RB_ATOMIC_START, use
+ *                     e.g. RingBufNoLock for buffers used by a single context
+ *                     or RingBufMutexLock for buffers shared between threads.
  */
-template<typename Type, size_t MaxElements>
-class RingBufCPP {
+template<typename Type, size_t MaxElements, typename LockPolicy = RingBufAtomicLock>
+class RingBufCPP : protected RingBufStorage<Type, MaxElements>, protected LockPolicy {
+    static_assert(MaxElements > 0, "MaxElements must be at least 1");
+#ifdef RB_MAX_STORAGE_BYTES
+    static_assert(sizeof(Type) * MaxElements <= (RB_MAX_STORAGE_BYTES),
+                  "Buffer does not fit in RB_MAX_STORAGE_BYTES");
+#endif
+
+    typedef RingBufStorage<Type, MaxElements> Storage;
+    typedef RingBufLockGuard<LockPolicy> Guard;
+
 public:
 
-    RingBufCPP() {
-        RB_ATOMIC_START
-            {
-                _numElements = 0;
-                _head = 0;
-            }
-        RB_ATOMIC_END
+    /**
+     * No code is run at startup for global buffers of trivially destructible
+     * types, the buffer is constant-initialized.
+     */
+    constexpr RingBufCPP() {
+    }
+
+    /**
+     * @return maximum number of elements in the buffer.
+     */
+    static constexpr size_t capacity() {
+        return MaxElements;
     }
 
+
+    /**
+     * @return size of the underlying array in bytes.
+     */
+    static constexpr size_t storageBytes() {
+        return sizeof(Type) * MaxElements;
+    }
+
+
+    /**
+     * @return true if `isFull()`, `numElements()` and `isEmpty()` read the
+     *         state without a critical section, which is the case if
+     *         `MaxElements` fits in a single byte and the lock policy only
+     *         protects against interrupts.
+     */
+    static constexpr bool lockFreeQueries() {
+        return (sizeof(typename Storage::IndexType) == 1) && LockPolicy::interruptsOnly();
+    }
+
+
     /**
      *  Add an element to the buffer.
      *
@@ -35,29 +151,141 @@ public:
      *  @return true on success.
      */
     bool add(const Type &obj) {
+        return emplace(obj);
+    }
+
+
+    /**
+     *  Add an element to the buffer by moving it.
+     *
+     *  @param obj[in] The element to move into the buffer.
+     *
+     *  @return true on success.
+     */
+    bool add(Type &&obj) {
+        return emplace(rbMove(obj));
+    }
+
+
+    /**
+     *  Construct an element in place at the end of the buffer.
+     *
+     *  @param args[in] Arguments forwarded to the constructor of the element.
+     *
+     *  @return true on success.
+     */
+    template<typename... Args>
+    bool emplace(Args &&... args) {
         bool ret = false;
 
-        RB_ATOMIC_START
-            {
-                if (!isFull()) {
-                    _buf[_head] = obj;
-                    _head = (_head + 1) % MaxElements;
-                    _numElements++;
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
 
-                    ret = true;
-                }
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            RB_INSTR_BEGIN();
+
+            if (_numElements < MaxElements) {
+                new (&_buf[_head], RingBufPlacement())
+                        Type(rbForward<Args>(args)...);
+                _head = Index::add(_head, 1);
+                _numElements++;
+
+                ret = true;
+            }
+
+            RB_STATS(sampleStats(!ret));
+            RB_INSTR_COUNT(_instr.failedAdds, !ret);
+            RB_INSTR_END(_instr.add);
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
+
+        return ret;
+    }
+
+
+    /**
+     *  Add an element to the buffer, overwriting the oldest element if the
+     *  buffer is full.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true if the oldest element was overwritten, false if there
+     *          was room for the element.
+     */
+    bool addOverwrite(const Type &obj) {
+        return emplaceOverwrite(obj);
+    }
+
+
+    /**
+     *  Add an element to the buffer by moving it, overwriting the oldest
+     *  element if the buffer is full.
+     *
+     *  @param obj[in] The element to move into the buffer.
+     *
+     *  @return true if the oldest element was overwritten, false if there
+     *          was room for the element.
+     */
+    bool addOverwrite(Type &&obj) {
+        return emplaceOverwrite(rbMove(obj));
+    }
+
+
+    /**
+     *  Construct an element in place at the end of the buffer, overwriting
+     *  the oldest element if the buffer is full.
+     *
+     *  @param args[in] Arguments forwarded to the constructor of the element.
+     *
+     *  @return true if the oldest element was overwritten, false if there
+     *          was room for the element.
+     */
+    template<typename... Args>
+    bool emplaceOverwrite(Args &&... args) {
+        bool ret = false;
+
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
+
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            RB_INSTR_BEGIN();
+
+            if (_numElements >= MaxElements) {
+                // The oldest element is at the head of a full buffer
+                _buf[_head].~Type();
+                _numElements--;
+                _removed++;
+
+                ret = true;
             }
-        RB_ATOMIC_END
+
+            new (&_buf[_head], RingBufPlacement())
+                    Type(rbForward<Args>(args)...);
+            _head = Index::add(_head, 1);
+            _numElements++;
+
+            RB_STATS(sampleStats(ret));
+            RB_INSTR_END(_instr.addOverwrite);
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
 
         return ret;
     }
 
 
     /**
-     * Remove last element from buffer, and copy it to destination.
+     * Remove last element from buffer, and move it to destination.
      *
      * @param dest[out] Pointer on the allocated object to which removed element
-     *                  will be copied.
+     *                  will be moved.
      *
      * @return true on success.
      */
@@ -65,22 +293,317 @@ public:
         bool ret = false;
         size_t tail;
 
-        RB_ATOMIC_START
-            {
-                if (!isEmpty()) {
-                    tail = getTail();
-                    *dest = _buf[tail];
-                    _numElements--;
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
 
-                    ret = true;
-                }
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            RB_INSTR_BEGIN();
+
+            if (_numElements) {
+                tail = getTail();
+                *dest = rbMove(_buf[tail]);
+                _buf[tail].~Type();
+                _numElements--;
+                _removed++;
+
+                ret = true;
+            }
+
+            RB_INSTR_COUNT(_instr.emptyPulls, !ret);
+            RB_INSTR_END(_instr.pull);
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
+
+        return ret;
+    }
+
+
+    /**
+     * Add multiple elements to the buffer. The elements are copied in at most
+     * two contiguous blocks within a single critical section.
+     *
+     * @param src[in] Array of elements to add.
+     * @param num     Number of elements in the `src` array.
+     *
+     * @return number of elements added, less than `num` if the buffer
+     *         became full.
+     */
+    size_t addMany(const Type *src, size_t num) {
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
+
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            RB_INSTR_BEGIN();
+
+            size_t free = MaxElements - _numElements;
+            size_t rejected = (num > free) ? (num - free) : 0;
+            if (num > free)
+                num = free;
+
+            size_t first = MaxElements - _head;
+            if (first > num)
+                first = num;
+
+            Copy::construct(&_buf[_head], src, first);
+            Copy::construct(_buf, src + first, num - first);
+            _head = Index::add(_head, num);
+            _numElements += num;
+
+            (void) rejected; // Only used by statistics/instrumentation
+            RB_STATS(sampleStats(rejected));
+            RB_INSTR_COUNT(_instr.failedAdds, rejected);
+            RB_INSTR_END(_instr.addMany);
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
+
+        return num;
+    }
+
+
+    /**
+     * Remove multiple oldest elements from the buffer and move them to
+     * destination. The elements are copied in at most two contiguous blocks
+     * within a single critical section.
+     *
+     * @param dest[out] Array to which removed elements will be moved.
+     * @param num       Maximum number of elements to remove, `dest` must be
+     *                  large enough to hold this many elements.
+     *
+     * @return number of elements removed, less than `num` if the buffer
+     *         became empty.
+     */
+    size_t pullMany(Type *dest, size_t num) {
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
+
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            RB_INSTR_BEGIN();
+
+            if (num > _numElements)
+                num = _numElements;
+
+            size_t tail = getTail();
+            size_t first = MaxElements - tail;
+            if (first > num)
+                first = num;
+
+            Copy::moveOut(dest, &_buf[tail], first);
+            Copy::moveOut(dest + first, _buf, num - first);
+            _numElements -= num;
+            _removed += num;
+
+            RB_INSTR_END(_instr.pullMany);
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
+
+        return num;
+    }
+
+
+    /**
+     * Reserve space for adding elements directly into the underlying array,
+     * e.g. by DMA or by constructing them in place. The reserved elements are
+     * added to the buffer only by calling `commitWrite()`. No other context
+     * may add elements to the buffer while the reservation is in progress.
+     * The returned elements are not constructed, use placement new for types
+     * which are not trivially copyable.
+     *
+     * @param contiguous[out] Number of elements which can be written to the
+     *                        returned location.
+     * @param offset          Number of free elements to skip. Use
+     *                        `offset = contiguous` of the first call to
+     *                        access the free elements at the start of the
+     *                        array.
+     *
+     * @return A pointer to the first free element (after `offset`) in the
+     *         array or `nullptr` if there are not more than `offset` free
+     *         elements.
+     */
+    Type *beginWrite(size_t &contiguous, size_t offset = 0) {
+        Type *ret = nullptr;
+
+        {
+            Guard guard(*this);
+
+            size_t free = MaxElements - _numElements;
+
+            contiguous = 0;
+
+            if (offset < free) {
+                size_t pos = Index::add(_head, offset);
+
+                contiguous = MaxElements - pos;
+                if (contiguous > free - offset)
+                    contiguous = free - offset;
+
+                ret = &_buf[pos];
             }
-        RB_ATOMIC_END
+        }
 
         return ret;
     }
 
 
+    /**
+     * Add elements previously written to the location returned by
+     * `beginWrite()` to the buffer.
+     *
+     * @param num Number of elements written, at most the number of
+     *            contiguous elements reported by `beginWrite()`.
+     *
+     * @return number of elements added.
+     */
+    size_t commitWrite(size_t num) {
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
+
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            size_t free = MaxElements - _numElements;
+            if (num > free)
+                num = free;
+
+            _head = Index::add(_head, num);
+            _numElements += num;
+
+            RB_STATS(sampleStats(0));
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
+
+        return num;
+    }
+
+
+    /**
+     * Access the oldest elements directly in the underlying array, without
+     * copying them out. The elements stay in the buffer until they are
+     * released by calling `commitRead()`, which also destroys them. No other
+     * context may remove elements from the buffer while the reservation is in
+     * progress.
+     *
+     * @param contiguous[out] Number of elements which can be read from the
+     *                        returned location.
+     * @param offset          Index of the first element to access, as used
+     *                        by `peek()`. Use `offset = contiguous` of the
+     *                        first call to access the elements after the
+     *                        end of the array.
+     *
+     * @return A pointer to the oldest element (at `offset`) in the array or
+     *         `nullptr` if there are not more than `offset` elements in the
+     *         buffer.
+     */
+    const Type *beginRead(size_t &contiguous, size_t offset = 0) {
+        const Type *ret = nullptr;
+
+        {
+            Guard guard(*this);
+
+            contiguous = 0;
+
+            if (offset < _numElements) {
+                size_t pos = Index::add(getTail(), offset);
+                size_t used = _numElements - offset;
+
+                contiguous = MaxElements - pos;
+                if (contiguous > used)
+                    contiguous = used;
+
+                ret = &_buf[pos];
+            }
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * Remove elements previously read from the location returned by
+     * `beginRead()` from the buffer.
+     *
+     * @param num Number of elements read, at most the number of contiguous
+     *            elements reported by `beginRead()`.
+     *
+     * @return number of elements removed.
+     */
+    size_t commitRead(size_t num) {
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
+
+        {
+            Guard guard(*this);
+
+            RB_WATERMARK(size_t before = _numElements);
+            if (num > _numElements)
+                num = _numElements;
+
+            destroy(getTail(), num);
+            _numElements -= num;
+            _removed += num;
+
+            RB_WATERMARK(watermark = checkWatermarks(before));
+        }
+        RB_WATERMARK(watermark.fire());
+
+        return num;
+    }
+
+
+    /**
+     * Process the oldest elements in place and remove them from the buffer.
+     * The number of elements to process is determined once at the start,
+     * elements are passed directly from the underlying array to `fn` (in at
+     * most two contiguous segments) and removed with a single index update
+     * at the end. Elements added meanwhile are left for the next call. No
+     * other context may remove elements from the buffer while this is in
+     * progress.
+     *
+     * @param fn  Function or functor called as `fn(const Type &)` for every
+     *            element, from the oldest to the newest one.
+     * @param max Maximum number of elements to process.
+     *
+     * @return number of elements processed and removed.
+     */
+    template<typename Function>
+    size_t drain(Function fn, size_t max = (size_t) -1) {
+        size_t tail;
+        size_t num;
+
+        {
+            Guard guard(*this);
+            tail = getTail();
+            num = _numElements;
+        }
+
+        if (num > max)
+            num = max;
+
+        size_t first = MaxElements - tail;
+        if (first > num)
+            first = num;
+
+        for (size_t i = 0; i < first; i++)
+            fn(static_cast<const Type &>(_buf[tail + i]));
+        for (size_t i = 0; i < num - first; i++)
+            fn(static_cast<const Type &>(_buf[i]));
+
+        return commitRead(num);
+    }
+
+
     /**
      * Peek at n'th element in the buffer.
      *
@@ -89,19 +612,114 @@ public:
      *            last added one is at the index `numElements() - 1`.
      *
      * @return A pointer to the num'th element or `nullptr` if there is less
-     *         elements currently in the buffer than provided index.
+     *         elements currently in the buffer than provided index. The
+     *         pointed element can be removed or overwritten by another context
+     *         at any time, use `peekMany()` or `peekCopy()` to get a
+     *         consistent copy instead.
      */
     Type *peek(size_t num) {
         Type *ret = nullptr;
 
-        RB_ATOMIC_START
+        {
+            Guard guard(*this);
+
+            RB_INSTR_BEGIN();
+
+            if (num < _numElements) //make sure not out of bounds
+                ret = &_buf[Index::add(getTail(), num)];
+
+            RB_INSTR_END(_instr.peek);
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * Copy multiple consecutive elements out of the buffer without removing
+     * them. The elements are copied in at most two contiguous blocks within a
+     * single critical section, so the copies are consistent even if other
+     * contexts modify the buffer.
+     *
+     * @param offset    Index of the first element to copy, 0 being the
+     *                  oldest element in the buffer.
+     * @param dest[out] Array to which elements will be copied.
+     * @param num       Maximum number of elements to copy, `dest` must be
+     *                  large enough to hold this many elements.
+     *
+     * @return number of elements copied, less than `num` if there is less
+     *         than `offset + num` elements in the buffer.
+     */
+    size_t peekMany(size_t offset, Type *dest, size_t num) {
+        {
+            Guard guard(*this);
+
+            if (offset > _numElements)
+                offset = _numElements;
+            if (num > _numElements - offset)
+                num = _numElements - offset;
+
+            size_t start = Index::add(getTail(), offset);
+            size_t first = MaxElements - start;
+            if (first > num)
+                first = num;
+
+            Copy::copy(dest, &_buf[start], first);
+            Copy::copy(dest + first, _buf, num - first);
+        }
+
+        return num;
+    }
+
+
+    /**
+     * Copy n'th element out of the buffer without removing it and without
+     * masking interrupts during the copy itself, which makes it suitable for
+     * large elements. If the element is removed (and its place possibly
+     * reused) by another context while it is being copied, the copy is
+     * retried.
+     *
+     * @param num       Index of the element to copy, 0 being the oldest
+     *                  element in the buffer.
+     * @param dest[out] Pointer on the allocated object to which the element
+     *                  will be copied.
+     *
+     * @return true on success, false if there is less elements currently in
+     *         the buffer than provided index.
+     */
+    bool peekCopy(size_t num, Type *dest) {
+        static_assert(RB_IS_TRIVIALLY_COPYABLE(Type),
+                      "Type must be trivially copyable to allow torn copies");
+        const Type *src;
+        size_t removed = 0;
+        bool valid;
+
+        do {
+            src = nullptr;
+
             {
-                if (num < _numElements) //make sure not out of bounds
-                    ret = &_buf[(getTail() + num) % MaxElements];
+                Guard guard(*this);
+
+                if (num < _numElements) {
+                    src = &_buf[Index::add(getTail(), num)];
+                    removed = _removed;
+                }
             }
-        RB_ATOMIC_END
 
-        return ret;
+            if (!src)
+                return false;
+
+            Copy::copy(dest, src, 1);
+
+            {
+                Guard guard(*this);
+
+                // Still in the buffer if at most `num` elements were removed
+                valid = (size_t) (_removed - removed) <= num;
+            }
+        } while (!valid);
+
+        return true;
     }
 
 
@@ -111,11 +729,13 @@ public:
     bool isFull() const {
         bool ret;
 
-        RB_ATOMIC_START
-            {
-                ret = _numElements >= MaxElements;
-            }
-        RB_ATOMIC_END
+        if (lockFreeQueries()) // Single byte reads are atomic
+            return RB_LOAD_ACQUIRE(_numElements) >= MaxElements;
+
+        {
+            Guard guard(*this);
+            ret = _numElements >= MaxElements;
+        }
 
         return ret;
     }
@@ -127,11 +747,13 @@ public:
     size_t numElements() const {
         size_t ret;
 
-        RB_ATOMIC_START
-            {
-                ret = _numElements;
-            }
-        RB_ATOMIC_END
+        if (lockFreeQueries()) // Single byte reads are atomic
+            return RB_LOAD_ACQUIRE(_numElements);
+
+        {
+            Guard guard(*this);
+            ret = _numElements;
+        }
 
         return ret;
     }
@@ -143,31 +765,218 @@ public:
     bool isEmpty() const {
         bool ret;
 
-        RB_ATOMIC_START
-            {
-                ret = !_numElements;
-            }
-        RB_ATOMIC_END
+        if (lockFreeQueries()) // Single byte reads are atomic
+            return !RB_LOAD_ACQUIRE(_numElements);
+
+        {
+            Guard guard(*this);
+            ret = !_numElements;
+        }
+
+        return ret;
+    }
+
+#ifdef RB_STATISTICS
+    /**
+     * @return copy of the usage statistics collected since construction or
+     *         the last reset, only available with RB_STATISTICS.
+     */
+    RingBufStats statistics() const {
+        RingBufStats ret;
+
+        {
+            Guard guard(*this);
+            ret = _stats;
+        }
+
+        return ret;
+    }
+
+
+    /**
+     * Reset the usage statistics, only available with RB_STATISTICS.
+     */
+    void resetStatistics() {
+        {
+            Guard guard(*this);
+            _stats = RingBufStats();
+        }
+    }
+#endif
+
+#ifdef RB_WATERMARKS
+    /**
+     * Set the callback called when the number of elements rises to `level`
+     * or above from below it, only available with RB_WATERMARKS. It is
+     * called by the adding method after its critical section, so it may
+     * take long (e.g. start writing a batch to flash) but any other context
+     * may meanwhile access the buffer. Classes wrapping the operations in
+     * their own critical section (the adding methods of RingBufWaitable,
+     * and the operations of RingBufTimed and RingBufWindow on their
+     * protected base) call it inside that section, with interrupts masked.
+     * The same holds for the per-lane buffers of RingBufPriority, which are
+     * protected members accessed within its critical sections.
+     *
+     * @param level    Number of elements at which to call `callback`.
+     * @param callback Callback, `nullptr` to remove the watermark.
+     * @param ctx      Argument passed to the callback.
+     */
+    void setHighWatermark(size_t level, RingBufWatermarkCallback callback, void *ctx = nullptr) {
+        {
+            Guard guard(*this);
+            _highWatermark.level = level;
+            _highWatermark.callback = callback;
+            _highWatermark.ctx = ctx;
+        }
+    }
+
+
+    /**
+     * Set the callback called when the number of elements falls to `level`
+     * or below from above it, only available with RB_WATERMARKS. It is
+     * called by the removing method after its critical section, see
+     * `setHighWatermark()` for the classes calling it inside their own.
+     *
+     * @param level    Number of elements at which to call `callback`.
+     * @param callback Callback, `nullptr` to remove the watermark.
+     * @param ctx      Argument passed to the callback.
+     */
+    void setLowWatermark(size_t level, RingBufWatermarkCallback callback, void *ctx = nullptr) {
+        {
+            Guard guard(*this);
+            _lowWatermark.level = level;
+            _lowWatermark.callback = callback;
+            _lowWatermark.ctx = ctx;
+        }
+    }
+#endif
+
+#ifdef RB_INSTRUMENTATION
+    /**
+     * @return copy of the instrumentation data collected since construction
+     *         or the last reset, only available with RB_INSTRUMENTATION.
+     */
+    RingBufInstrumentation instrumentation() const {
+        RingBufInstrumentation ret;
+
+        {
+            Guard guard(*this);
+            ret = _instr;
+        }
 
         return ret;
     }
 
+
+    /**
+     * Reset the instrumentation data, only available with RB_INSTRUMENTATION.
+     */
+    void resetInstrumentation() {
+        {
+            Guard guard(*this);
+            _instr = RingBufInstrumentation();
+        }
+    }
+#endif
+
 protected:
+    typedef RingBufIndex<MaxElements> Index;
+    typedef RingBufCopy<Type> Copy;
+    typedef typename Storage::IndexType IndexType;
+
+    using Storage::_buf;
+    using Storage::_head;
+    using Storage::_numElements;
+    using Storage::_removed;
+
+
     /**
      * Calculates the index of the oldest element in the array.
      *
      * @return index of the element in array.
      */
     size_t getTail() const {
-        return (_head + (MaxElements - _numElements)) % MaxElements;
+        return Index::add(_head, MaxElements - _numElements);
     }
 
 
-    /** Underlying array. */
-    Type _buf[MaxElements];
+#ifdef RB_STATISTICS
+    /**
+     * Updates the usage statistics after an addition, must be called from
+     * within the critical section.
+     *
+     * @param rejected Number of elements rejected or overwritten.
+     */
+    void sampleStats(size_t rejected) {
+        _stats.overflows += rejected;
+        if (_numElements > _stats.peak)
+            _stats.peak = _numElements;
+
+        // Division by a constant, only done with the statistics enabled
+        _stats.histogram[_numElements * RB_STATS_HISTOGRAM_BINS / (MaxElements + 1)]++;
+    }
+#endif
 
-    size_t _head;
-    size_t _numElements;
+
+#ifdef RB_WATERMARKS
+    /**
+     * Checks whether an operation crossed a watermark, must be called from
+     * within the critical section at the end of the operation.
+     *
+     * @param before Number of elements before the operation.
+     *
+     * @return the callback to call after the critical section, if any.
+     */
+    RingBufWatermarkEvent checkWatermarks(size_t before) const {
+        RingBufWatermarkEvent ret;
+        const RingBufWatermark *mark = nullptr;
+        size_t now = _numElements;
+
+        if (now > before) {
+            if (before < _highWatermark.level && now >= _highWatermark.level)
+                mark = &_highWatermark;
+        }
+        else if (now < before) {
+            if (before > _lowWatermark.level && now <= _lowWatermark.level)
+                mark = &_lowWatermark;
+        }
+
+        if (mark) {
+            ret.callback = mark->callback;
+            ret.ctx = mark->ctx;
+            ret.numElements = now;
+        }
+
+        return ret;
+    }
+#endif
+
+
+    /**
+     * Destroys elements in the array.
+     *
+     * @param index Index of the first element in array to destroy.
+     * @param num   Number of elements to destroy, wrapping around the end of
+     *              the array.
+     */
+    void destroy(size_t index, size_t num) {
+        for (; num; num--) {
+            _buf[index].~Type();
+            index = Index::add(index, 1);
+        }
+    }
+
+
+#ifdef RB_STATISTICS
+    RingBufStats _stats;
+#endif
+#ifdef RB_INSTRUMENTATION
+    RingBufInstrumentation _instr;
+#endif
+#ifdef RB_WATERMARKS
+    RingBufWatermark _highWatermark;
+    RingBufWatermark _lowWatermark;
+#endif
 private:
 
 };
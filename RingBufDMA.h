@@ -0,0 +1,182 @@
+#ifndef EM_RINGBUF_DMA_CPP_H
+#define EM_RINGBUF_DMA_CPP_H
+
+#include "RingBufCPP.h"
+
+/**
+ * RingBufCPP adapter for peripherals which write received data into the
+ * buffer's underlying array on their own, using circular or double-buffered
+ * DMA. Instead of calling `add()` for every element, the producer index is
+ * only advanced when the hardware reports progress, the consumer side is the
+ * same as for RingBufCPP.
+ *
+ * Two ways of reporting progress are supported:
+ *
+ * - Circular DMA with a readable write position: call `dmaUpdate()` with the
+ *   position (element index) the DMA will write next, at least twice per pass
+ *   over the array, e.g. on half and full transfer events.
+ *
+ * - Double-buffered DMA (nRF5 EasyDMA UARTE/SAADC, which latch the next
+ *   pointer on the STARTED event): the array is split into `Chunks` equally
+ *   sized chunks. Point the peripheral at `dmaChunk()` of the chunk following
+ *   the one in progress on every STARTED event and call `dmaChunkDone()` on
+ *   every END event. For an nRF52 UARTE with the ENDRX_STARTRX short:
+ *
+ *       NRF_UARTE0->RXD.PTR = (uint32_t) rx.dmaChunk(0);
+ *       NRF_UARTE0->RXD.MAXCNT = rx.dmaChunkLength();
+ *       NRF_UARTE0->TASKS_STARTRX = 1;
+ *       ...
+ *       if (NRF_UARTE0->EVENTS_RXSTARTED) // Set up the next chunk.
+ *           NRF_UARTE0->RXD.PTR = (uint32_t) rx.dmaChunk(++next);
+ *       if (NRF_UARTE0->EVENTS_ENDRX)
+ *           rx.dmaChunkDone();
+ *
+ * Peripherals without DMA (e.g. the ESP8266 UART FIFO) should drain their FIFO
+ * in the FIFO-full/timeout interrupt directly into `beginWrite()` and call
+ * `commitWrite()` once per interrupt instead.
+ *
+ * The hardware does not respect the consumer, so if the buffer is not drained
+ * quickly enough the oldest elements are overwritten. Such elements are
+ * dropped from the buffer and counted, see `overruns()`.
+ *
+ * @tparam Type        Type of the elements being stored.
+ * @tparam MaxElements Maximum number of elements in this buffer.
+ * @tparam Chunks      Number of chunks the array is split into for the
+ *                     double-buffered mode. Must be at least two and must
+ *                     divide `MaxElements`.
+ */
+template<typename Type, size_t MaxElements, size_t Chunks = 2>
+class RingBufDMA : public RingBufCPP<Type, MaxElements> {
+    typedef RingBufCPP<Type, MaxElements> Base;
+    typedef typename Base::Index Index;
+
+    static_assert(RB_IS_TRIVIALLY_COPYABLE(Type),
+                  "DMA can only be used with trivially copyable types");
+    static_assert(Chunks >= 2 && (MaxElements % Chunks) == 0,
+                  "MaxElements must be divisible by at least two chunks");
+
+public:
+
+    RingBufDMA() :
+            _nextChunk(0),
+            _overruns(0) {
+    }
+
+    /**
+     * @return the start of the underlying array, to be used as the DMA
+     *         destination address in the circular mode.
+     */
+    Type *dmaBuffer() {
+        return this->_buf;
+    }
+
+
+    /**
+     * @return length of the underlying array in elements, to be used as the
+     *         DMA transfer length in the circular mode.
+     */
+    static size_t dmaLength() {
+        return MaxElements;
+    }
+
+
+    /**
+     * @param chunk Index of the chunk, wraps around after `Chunks`.
+     *
+     * @return the start of the chunk, to be used as the DMA destination
+     *         address in the double-buffered mode.
+     */
+    Type *dmaChunk(size_t chunk) {
+        return &this->_buf[(chunk % Chunks) * (MaxElements / Chunks)];
+    }
+
+
+    /**
+     * @return length of each chunk in elements, to be used as the DMA
+     *         transfer length in the double-buffered mode.
+     */
+    static size_t dmaChunkLength() {
+        return MaxElements / Chunks;
+    }
+
+
+    /**
+     * Add all elements the DMA has written since the last update to the
+     * buffer.
+     *
+     * @param position Index of the element in the underlying array which
+     *                 the DMA will write next.
+     *
+     * @return number of elements added.
+     */
+    size_t dmaUpdate(size_t position) {
+        size_t added;
+
+        if (position >= MaxElements)
+            position -= MaxElements;
+
+        RB_WATERMARK(RingBufWatermarkEvent watermark);
+
+        RB_ATOMIC_START
+            {
+                RB_WATERMARK(size_t before = this->_numElements);
+                added = Index::add(position, MaxElements - this->_head);
+
+                size_t num = this->_numElements + added;
+                if (num > MaxElements) {
+                    _overruns += num - MaxElements;
+                    this->_removed += num - MaxElements;
+                    num = MaxElements;
+                }
+
+                this->_numElements = num;
+                this->_head = position;
+
+                RB_WATERMARK(watermark = this->checkWatermarks(before));
+            }
+        RB_ATOMIC_END
+        RB_WATERMARK(watermark.fire());
+
+        return added;
+    }
+
+
+    /**
+     * Add all elements of the oldest chunk in progress to the buffer. Call
+     * on every DMA transfer completion in the double-buffered mode.
+     *
+     * @return number of elements added.
+     */
+    size_t dmaChunkDone() {
+        _nextChunk = (_nextChunk + 1 < Chunks) ? (_nextChunk + 1) : 0;
+
+        return dmaUpdate(_nextChunk * (MaxElements / Chunks));
+    }
+
+
+    /**
+     * @return number of elements overwritten by the DMA before they were
+     *         removed from the buffer.
+     */
+    size_t overruns() const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _overruns;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+protected:
+    /** Index of the chunk the DMA is currently writing. */
+    size_t _nextChunk;
+
+    size_t _overruns;
+private:
+
+};
+
+#endif
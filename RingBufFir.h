@@ -0,0 +1,182 @@
+#ifndef EM_RINGBUF_FIR_CPP_H
+#define EM_RINGBUF_FIR_CPP_H
+
+#include "RingBufHelpers.h"
+
+#if defined(__ARM_FEATURE_DSP)
+    // Cortex-M4/M7/M33, dual 16-bit multiply-accumulate with SMLAD
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+/**
+ * Dot product of two vectors of Q15 samples, using the SIMD instructions of
+ * the platform (SMLAD on Cortex-M with the DSP extension, SSE2 or NEON on
+ * hosts) where available. The accumulator has 32 bits, so the sum of the
+ * absolute values of the products must fit in it.
+ *
+ * @param a   First vector, no alignment required.
+ * @param b   Second vector, no alignment required.
+ * @param num Number of elements in the vectors.
+ *
+ * @return the sum of the products of the elements, in Q30.
+ */
+inline int32_t rbDotQ15(const int16_t *a, const int16_t *b, size_t num) {
+    int32_t acc = 0;
+    size_t i = 0;
+
+#if defined(__ARM_FEATURE_DSP)
+    for (; i + 2 <= num; i += 2) {
+        uint32_t x, y;
+
+        memcpy(&x, &a[i], sizeof(x));
+        memcpy(&y, &b[i], sizeof(y));
+        __asm__("smlad %0, %1, %2, %0" : "+r"(acc) : "r"(x), "r"(y));
+    }
+#elif defined(__SSE2__)
+    __m128i sum = _mm_setzero_si128();
+
+    for (; i + 8 <= num; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *) &a[i]);
+        __m128i y = _mm_loadu_si128((const __m128i *) &b[i]);
+
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(x, y));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    acc = _mm_cvtsi128_si32(sum);
+#elif defined(__ARM_NEON)
+    int32x4_t sum = vdupq_n_s32(0);
+
+    for (; i + 4 <= num; i += 4)
+        sum = vmlal_s16(sum, vld1_s16(&a[i]), vld1_s16(&b[i]));
+
+    int32x2_t half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+    acc = vget_lane_s32(vpadd_s32(half, half), 0);
+#endif
+
+    for (; i < num; i++)
+        acc += (int32_t) a[i] * b[i];
+
+    return acc;
+}
+
+
+/**
+ * FIR filter (and decimator) of Q15 samples, reading the samples directly
+ * from the underlying array of a RingBufCPP, RingBufSPSC or RingBufDMA of
+ * `int16_t` through `beginRead()`, without copying them to a scratch array.
+ * Windows crossing the end of the array are calculated in two parts with the
+ * coefficients split at the seam, so the inner loops never check for the
+ * wrap around.
+ *
+ * Only one context may remove samples from the buffer.
+ *
+ * @tparam Taps       Number of coefficients.
+ * @tparam Decimation One output is calculated for every `Decimation` input
+ *                    samples.
+ */
+template<size_t Taps, size_t Decimation = 1>
+class RingBufFir {
+    static_assert(Taps > 0, "At least one coefficient is required");
+    static_assert(Decimation > 0, "Decimation must be at least 1");
+
+public:
+
+    /**
+     * @param coefficients Array of `Taps` coefficients in Q15, the first one
+     *                     applied to the oldest sample of the window (the
+     *                     impulse response in reverse order). The array is
+     *                     not copied.
+     */
+    explicit RingBufFir(const int16_t *coefficients) :
+            _coefficients(coefficients),
+            _skip(0) {
+    }
+
+    /**
+     * Calculate outputs for all complete windows of samples in the buffer
+     * and remove the samples which are not needed for the next outputs
+     * anymore. The last `Taps - 1` samples stay in the buffer.
+     *
+     * @param ring     Buffer of `int16_t` samples.
+     * @param out[out] Array to which the outputs are written, in Q15 and
+     *                 saturated.
+     * @param maxOut   Maximum number of outputs, the size of `out`.
+     *
+     * @return number of outputs written.
+     */
+    template<typename Ring>
+    size_t process(Ring &ring, int16_t *out, size_t maxOut) {
+        size_t first;
+        size_t second = 0;
+        const int16_t *seg1 = ring.beginRead(first);
+
+        if (!seg1)
+            return 0;
+
+        const int16_t *seg2 = ring.beginRead(second, first);
+        size_t available = first + second;
+        size_t start = _skip;
+        size_t num = 0;
+
+        for (; (num < maxOut) && (start + Taps <= available); start += Decimation)
+            out[num++] = saturate(filter(seg1, first, seg2, start));
+
+        // With Decimation > Taps the next window can start past the samples
+        size_t consumed = (start < available) ? start : available;
+        _skip = start - consumed;
+        ring.commitRead(consumed);
+
+        return num;
+    }
+
+
+    /**
+     * Forget the decimation phase, the next output is calculated from the
+     * oldest samples in the buffer.
+     */
+    void reset() {
+        _skip = 0;
+    }
+
+protected:
+    /**
+     * @return the output for the window at `start`, the samples being split
+     *         in two segments, in Q30.
+     */
+    int32_t filter(const int16_t *seg1, size_t first, const int16_t *seg2, size_t start) const {
+        if (start + Taps <= first)
+            return rbDotQ15(&seg1[start], _coefficients, Taps);
+        if (start >= first)
+            return rbDotQ15(&seg2[start - first], _coefficients, Taps);
+
+        size_t split = first - start;
+        return rbDotQ15(&seg1[start], _coefficients, split) +
+               rbDotQ15(seg2, &_coefficients[split], Taps - split);
+    }
+
+
+    /** Converts Q30 to Q15 with rounding and saturation. */
+    static int16_t saturate(int32_t acc) {
+        acc = ((acc >> 14) + 1) >> 1;
+
+        if (acc > 32767)
+            return 32767;
+        if (acc < -32768)
+            return -32768;
+        return (int16_t) acc;
+    }
+
+
+    const int16_t *_coefficients;
+    /** Number of samples to skip before the next window, see `process()`. */
+    size_t _skip;
+private:
+
+};
+
+#endif
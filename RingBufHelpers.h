@@ -15,6 +15,9 @@
     #include <stdint.h> // NOLINT
 #endif
 
+#include <stddef.h> // NOLINT
+#include <string.h> // NOLINT
+
 #ifdef ARDUINO
 
     #if defined(ARDUINO_ARCH_AVR)
@@ -56,4 +59,441 @@
     #warning "Implement RB_ATOMIC_START and RB_ATOMIC_END macros for safe ISR operation!"
 #endif
 
+
+/**
+ * Index arithmetic for a buffer of `Size` elements, used instead of the
+ * modulo operator which is an expensive library call on cores without a
+ * hardware divider (AVR, Cortex-M0). If `Size` is a power of two the index
+ * is wrapped with a mask, otherwise with a conditional subtraction.
+ *
+ * @tparam Size       Number of elements the index is wrapping around.
+ * @tparam PowerOfTwo Selected automatically, do not provide.
+ */
+template<size_t Size, bool PowerOfTwo = ((Size & (Size - 1)) == 0)>
+struct RingBufIndex {
+    /**
+     * @param index  Index to advance.
+     * @param offset Number of elements to advance for. The sum of `index` and
+     *               `offset` must be less than `2 * Size`.
+     *
+     * @return `(index + offset) % Size`.
+     */
+    static size_t add(size_t index, size_t offset) {
+        index += offset;
+        if (index >= Size)
+            index -= Size;
+        return index;
+    }
+};
+
+template<size_t Size>
+struct RingBufIndex<Size, true> {
+    static size_t add(size_t index, size_t offset) {
+        return (index + offset) & (Size - 1);
+    }
+};
+
+
+/**
+ * Selects the smallest unsigned type able to hold values up to `Max`, used
+ * for the buffer indices. Single byte indices are cheaper and their accesses
+ * are inherently atomic on 8-bit cores.
+ *
+ * @tparam Max Maximum value of the index.
+ */
+template<size_t Max>
+struct RingBufIndexType {
+    template<bool Fits8, bool Fits16, bool Fits32, int Dummy = 0>
+    struct Select { typedef size_t type; };
+
+    template<bool Fits16, bool Fits32, int Dummy>
+    struct Select<true, Fits16, Fits32, Dummy> { typedef uint8_t type; };
+
+    template<bool Fits32, int Dummy>
+    struct Select<false, true, Fits32, Dummy> { typedef uint16_t type; };
+
+    template<int Dummy>
+    struct Select<false, false, true, Dummy> { typedef uint32_t type; };
+
+    typedef typename Select<(Max <= 0xFFu), (Max <= 0xFFFFu),
+                            (Max <= 0xFFFFFFFFul)>::type type;
+};
+
+
+/*
+ * Clang reports __GNUC__ == 4 but supports the standard traits, the old
+ * __has_trivial_* builtins are deprecated there and ignore the assignment
+ * and the destructor.
+ */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))
+    #define RB_IS_TRIVIALLY_COPYABLE(Type) __is_trivially_copyable(Type)
+    #define RB_IS_TRIVIALLY_CONSTRUCTIBLE(Type) __is_trivially_constructible(Type)
+#else
+    #define RB_IS_TRIVIALLY_COPYABLE(Type) __has_trivial_copy(Type)
+    #define RB_IS_TRIVIALLY_CONSTRUCTIBLE(Type) __has_trivial_constructor(Type)
+#endif
+
+#ifdef __has_builtin
+    #if __has_builtin(__is_trivially_destructible)
+        #define RB_IS_TRIVIALLY_DESTRUCTIBLE(Type) __is_trivially_destructible(Type)
+    #endif
+#endif
+#ifndef RB_IS_TRIVIALLY_DESTRUCTIBLE
+    #define RB_IS_TRIVIALLY_DESTRUCTIBLE(Type) __has_trivial_destructor(Type)
+#endif
+
+
+/*
+ * Upper limit of the storage of a single buffer in bytes, checked at compile
+ * time. Defaults to the size of the SRAM on AVR, define it before including
+ * the library to check against the budget of a buffer on any platform.
+ */
+#if !defined(RB_MAX_STORAGE_BYTES) && defined(ARDUINO_ARCH_AVR) && defined(RAMEND) && defined(RAMSTART)
+    #define RB_MAX_STORAGE_BYTES (RAMEND - RAMSTART + 1)
+#endif
+
+/*
+ * Minimal replacements for `std::move()`, `std::forward()` and placement new,
+ * as the standard library headers are not available on all platforms (AVR).
+ */
+template<typename T> struct RingBufRemoveRef { typedef T type; };
+template<typename T> struct RingBufRemoveRef<T &> { typedef T type; };
+template<typename T> struct RingBufRemoveRef<T &&> { typedef T type; };
+
+template<typename T>
+inline typename RingBufRemoveRef<T>::type &&rbMove(T &&obj) {
+    return static_cast<typename RingBufRemoveRef<T>::type &&>(obj);
+}
+
+template<typename T>
+inline T &&rbForward(typename RingBufRemoveRef<T>::type &obj) {
+    return static_cast<T &&>(obj);
+}
+
+/** Tag selecting the placement new below: `new (ptr, RingBufPlacement()) T`. */
+struct RingBufPlacement {};
+
+inline void *operator new(size_t, void *ptr, RingBufPlacement) noexcept {
+    return ptr;
+}
+
+inline void operator delete(void *, void *, RingBufPlacement) noexcept {
+}
+
+
+/**
+ * Copies, constructs or moves out a contiguous block of elements, using
+ * `memcpy()` if the type allows it and element-wise operations otherwise.
+ *
+ * @tparam Type    Type of the elements being copied.
+ * @tparam Trivial Selected automatically, do not provide.
+ */
+template<typename Type, bool Trivial = RB_IS_TRIVIALLY_COPYABLE(Type)>
+struct RingBufCopy {
+    /** Copy-assign `num` elements to already constructed `dest`. */
+    static void copy(Type *dest, const Type *src, size_t num) {
+        for (size_t i = 0; i < num; i++)
+            dest[i] = src[i];
+    }
+
+    /** Copy-construct `num` elements in the uninitialized `dest`. */
+    static void construct(Type *dest, const Type *src, size_t num) {
+        for (size_t i = 0; i < num; i++)
+            new (&dest[i], RingBufPlacement()) Type(src[i]);
+    }
+
+    /** Move-assign `num` elements to `dest` and destroy them in `src`. */
+    static void moveOut(Type *dest, Type *src, size_t num) {
+        for (size_t i = 0; i < num; i++) {
+            dest[i] = rbMove(src[i]);
+            src[i].~Type();
+        }
+    }
+};
+
+template<typename Type>
+struct RingBufCopy<Type, true> {
+    static void copy(Type *dest, const Type *src, size_t num) {
+        memcpy(dest, src, num * sizeof(Type));
+    }
+
+    static void construct(Type *dest, const Type *src, size_t num) {
+        memcpy(dest, src, num * sizeof(Type));
+    }
+
+    static void moveOut(Type *dest, Type *src, size_t num) {
+        memcpy(dest, src, num * sizeof(Type));
+    }
+};
+
+
+/*
+ * Opt-in instrumentation of RingBufCPP, enabled by defining RB_INSTRUMENTATION
+ * before including the library. It records the number of cycles spent inside
+ * the critical section of each operation (the time interrupts are masked) and
+ * counts failed `add()` and `pull()` calls, see `RingBufCPP::instrumentation()`.
+ *
+ * The cycle counter can be provided by defining RB_CYCLE_COUNT() (and
+ * RB_CYCLE_TYPE, its unsigned type which wraps around). Defaults are the DWT
+ * cycle counter on nRF52 (enable it with `rbCycleCounterInit()`), the CCOUNT
+ * register on ESP8266, Timer1 on AVR (counting at the prescaler configured by
+ * the application) and the time-stamp counter on x86 hosts.
+ */
+#ifdef RB_INSTRUMENTATION
+    #ifndef RB_CYCLE_COUNT
+        #if defined(NORDIC_NRF5x) && (defined(NRF52) || defined(NRF52_SERIES))
+            #define RB_CYCLE_COUNT() (DWT->CYCCNT)
+
+            static inline void rbCycleCounterInit() {
+                CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+                DWT->CYCCNT = 0;
+                DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+            }
+
+        #elif defined(ARDUINO_ARCH_ESP8266)
+            #define RB_CYCLE_COUNT() (__extension__({uint32_t ccount; \
+                    __asm__ __volatile__("rsr %0,ccount" : "=a" (ccount)); ccount;}))
+        #elif defined(ARDUINO_ARCH_AVR)
+            #define RB_CYCLE_TYPE uint16_t
+            #define RB_CYCLE_COUNT() (TCNT1)
+        #elif defined(__i386__) || defined(__x86_64__)
+            #define RB_CYCLE_COUNT() ((uint32_t) __builtin_ia32_rdtsc())
+        #else
+            #error "Define RB_CYCLE_COUNT() returning the cycle counter of this platform"
+        #endif
+    #endif
+
+    #ifndef RB_CYCLE_TYPE
+        #define RB_CYCLE_TYPE uint32_t
+    #endif
+
+    /** Cycle statistics of one operation. */
+    struct RingBufOpStats {
+        constexpr RingBufOpStats() :
+                count(0),
+                minCycles(~(RB_CYCLE_TYPE) 0),
+                maxCycles(0),
+                totalCycles(0) {
+        }
+
+        void record(RB_CYCLE_TYPE cycles) {
+            count++;
+            if (cycles < minCycles)
+                minCycles = cycles;
+            if (cycles > maxCycles)
+                maxCycles = cycles;
+            totalCycles += cycles;
+        }
+
+        /** Number of calls. */
+        uint32_t count;
+        /** Minimum cycles in the critical section, maximum value if not called. */
+        RB_CYCLE_TYPE minCycles;
+        /** Maximum cycles in the critical section. */
+        RB_CYCLE_TYPE maxCycles;
+        /** Sum of cycles in the critical section of all calls. */
+        uint64_t totalCycles;
+    };
+
+    /** Instrumentation data of a buffer. */
+    struct RingBufInstrumentation {
+        constexpr RingBufInstrumentation() :
+                failedAdds(0),
+                emptyPulls(0) {
+        }
+
+        RingBufOpStats add;
+        RingBufOpStats addOverwrite;
+        RingBufOpStats pull;
+        RingBufOpStats addMany;
+        RingBufOpStats pullMany;
+        RingBufOpStats peek;
+
+        /** Number of elements not added because the buffer was full. */
+        uint32_t failedAdds;
+        /** Number of `pull()` calls on an empty buffer. */
+        uint32_t emptyPulls;
+    };
+
+    #define RB_INSTR_BEGIN() RB_CYCLE_TYPE _rbCycles = RB_CYCLE_COUNT()
+    #define RB_INSTR_END(stats) (stats).record((RB_CYCLE_TYPE) (RB_CYCLE_COUNT() - _rbCycles))
+    #define RB_INSTR_COUNT(counter, num) (counter) += (num)
+#else
+    #define RB_INSTR_BEGIN()
+    #define RB_INSTR_END(stats)
+    #define RB_INSTR_COUNT(counter, num)
+#endif
+
+
+/*
+ * Opt-in usage statistics of RingBufCPP, enabled by defining RB_STATISTICS
+ * before including the library, see `RingBufCPP::statistics()`. They are
+ * meant for sizing the buffers on the target based on actual data.
+ */
+#ifdef RB_STATISTICS
+    #ifndef RB_STATS_HISTOGRAM_BINS
+        #define RB_STATS_HISTOGRAM_BINS 8
+    #endif
+
+    /** Usage statistics of a buffer. */
+    struct RingBufStats {
+        constexpr RingBufStats() :
+                peak(0),
+                overflows(0),
+                histogram() {
+        }
+
+        /** Maximum number of elements which were in the buffer at once. */
+        size_t peak;
+        /** Number of elements rejected or overwritten due to a full buffer. */
+        uint32_t overflows;
+        /**
+         * Number of additions after which the number of elements `n` was
+         * such that `n * RB_STATS_HISTOGRAM_BINS / (MaxElements + 1)` equals
+         * the index of the bin.
+         */
+        uint32_t histogram[RB_STATS_HISTOGRAM_BINS];
+    };
+
+    #define RB_STATS(statement) statement
+#else
+    #define RB_STATS(statement)
+#endif
+
+
+/*
+ * Opt-in watermark callbacks of RingBufCPP, enabled by defining RB_WATERMARKS
+ * before including the library, see `RingBufCPP::setHighWatermark()`. They
+ * let the consumer be woken only once a batch of elements is available.
+ */
+#ifdef RB_WATERMARKS
+    /**
+     * Called when the number of elements crosses a watermark, after the
+     * critical section of the operation which caused it.
+     *
+     * @param ctx         Context given when setting the watermark.
+     * @param numElements Number of elements in the buffer after the operation.
+     */
+    typedef void (*RingBufWatermarkCallback)(void *ctx, size_t numElements);
+
+    /** Watermark level with its callback. */
+    struct RingBufWatermark {
+        constexpr RingBufWatermark() :
+                level(0),
+                callback(nullptr),
+                ctx(nullptr) {
+        }
+
+        size_t level;
+        /** Callback, `nullptr` if the watermark is not set. */
+        RingBufWatermarkCallback callback;
+        void *ctx;
+    };
+
+    /** Watermark crossed by an operation, to be reported after it. */
+    struct RingBufWatermarkEvent {
+        constexpr RingBufWatermarkEvent() :
+                callback(nullptr),
+                ctx(nullptr),
+                numElements(0) {
+        }
+
+        void fire() const {
+            if (callback)
+                callback(ctx, numElements);
+        }
+
+        RingBufWatermarkCallback callback;
+        void *ctx;
+        size_t numElements;
+    };
+
+    #define RB_WATERMARK(statement) statement
+#else
+    #define RB_WATERMARK(statement)
+#endif
+
+
+/*
+ * Cache line size used by the lock-free variants to place the indices written
+ * by producers and the ones written by consumers on separate cache lines,
+ * preventing false sharing between cores. Set it to 0 to disable the padding,
+ * it is disabled by default on single-core MCUs where it would only waste RAM.
+ *
+ * With RB_CACHED_INDICES set, the producer and the consumer additionally keep
+ * a private copy of the other side's index and only re-read the shared one
+ * when the copy indicates the buffer is full or empty.
+ */
+#ifndef RB_CACHE_LINE_SIZE
+    #if defined(ARDUINO_ARCH_ESP32)
+        #define RB_CACHE_LINE_SIZE 32
+    #elif defined(ARDUINO) || defined(NORDIC_NRF5x)
+        #define RB_CACHE_LINE_SIZE 0
+    #else
+        #define RB_CACHE_LINE_SIZE 64
+    #endif
+#endif
+
+#if RB_CACHE_LINE_SIZE > 0
+    #define RB_CACHE_ALIGNED alignas(RB_CACHE_LINE_SIZE)
+#else
+    #define RB_CACHE_ALIGNED
+#endif
+
+#ifndef RB_CACHED_INDICES
+    #define RB_CACHED_INDICES (RB_CACHE_LINE_SIZE > 0)
+#endif
+
+
+/*
+ * Memory ordering primitives used by the lock-free buffer variants.
+ *
+ * On single-core MCUs a volatile access together with a compiler barrier is
+ * sufficient, the only thing that must be prevented is the compiler moving
+ * element accesses across the index update. On AVR the index accesses must
+ * additionally be made atomic if the index is wider than one byte.
+ * Everywhere else the compiler's `__atomic` builtins are used.
+ */
+#define RB_COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+#if defined(ARDUINO_ARCH_AVR)
+    #define RB_LOAD_ACQUIRE(var) (__extension__({ \
+            __typeof__((var) + 0) _rbVal; \
+            if (sizeof(var) == 1) { \
+                _rbVal = *(volatile __typeof__(var) *) &(var); \
+            } else { \
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { \
+                    _rbVal = *(volatile __typeof__(var) *) &(var); \
+                } \
+            } \
+            RB_COMPILER_BARRIER(); \
+            _rbVal; }))
+
+    #define RB_STORE_RELEASE(var, val) do { \
+            __typeof__(var) _rbVal = (val); \
+            RB_COMPILER_BARRIER(); \
+            if (sizeof(var) == 1) { \
+                *(volatile __typeof__(var) *) &(var) = _rbVal; \
+            } else { \
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { \
+                    *(volatile __typeof__(var) *) &(var) = _rbVal; \
+                } \
+            } } while (0)
+
+#elif defined(ARDUINO_ARCH_ESP8266) || defined(NORDIC_NRF5x)
+    #define RB_LOAD_ACQUIRE(var) (__extension__({ \
+            __typeof__(var) _rbVal = *(volatile __typeof__(var) *) &(var); \
+            RB_COMPILER_BARRIER(); \
+            _rbVal; }))
+
+    #define RB_STORE_RELEASE(var, val) do { \
+            __typeof__(var) _rbVal = (val); \
+            RB_COMPILER_BARRIER(); \
+            *(volatile __typeof__(var) *) &(var) = _rbVal; } while (0)
+
+#else
+    #define RB_LOAD_ACQUIRE(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+    #define RB_STORE_RELEASE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#endif
+
 #endif
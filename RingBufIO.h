@@ -0,0 +1,192 @@
+#ifndef EM_RINGBUF_IO_CPP_H
+#define EM_RINGBUF_IO_CPP_H
+
+#include "RingBufHelpers.h"
+
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+    #include <sys/types.h>
+    #include <sys/uio.h>
+#endif
+
+/*
+ * Transfers of bytes between a buffer of `uint8_t` (or `char`) elements and
+ * an I/O object, directly from and to the underlying array of the buffer.
+ * The (at most two) contiguous blocks of the buffer are passed to the I/O in
+ * single calls and only the bytes it accepted are removed from (or added to)
+ * the buffer. Works with RingBufCPP, RingBufSPSC, RingBufDMA and RingBufVM;
+ * only one context may remove (add) elements while a transfer is in
+ * progress.
+ */
+
+#ifdef ARDUINO
+/**
+ * Write the contents of the buffer to an Arduino `Print` (`Serial`, a
+ * `Client`, ...) with at most two `write()` calls.
+ *
+ * @param ring Buffer of bytes.
+ * @param out  Destination of the bytes.
+ * @param max  Maximum number of bytes to write, e.g.
+ *             `Serial.availableForWrite()` to never block.
+ *
+ * @return number of bytes written and removed from the buffer.
+ */
+template<typename Ring>
+size_t rbWriteTo(Ring &ring, Print &out, size_t max = (size_t) -1) {
+    size_t written = 0;
+
+    for (int segment = 0; (segment < 2) && (written < max); segment++) {
+        size_t len;
+        const uint8_t *data = (const uint8_t *) ring.beginRead(len);
+
+        static_assert(sizeof(*ring.beginRead(len)) == 1, "Elements must be bytes");
+        if (!data)
+            break;
+
+        if (len > max - written)
+            len = max - written;
+
+        size_t accepted = out.write(data, len);
+        ring.commitRead(accepted);
+        written += accepted;
+
+        if (accepted < len)
+            break;
+    }
+
+    return written;
+}
+
+
+/**
+ * Read the bytes available in an Arduino `Stream` into the buffer, with at
+ * most two `readBytes()` calls which do not wait for more data.
+ *
+ * @param ring Buffer of bytes.
+ * @param in   Source of the bytes.
+ * @param max  Maximum number of bytes to read.
+ *
+ * @return number of bytes read and added to the buffer.
+ */
+template<typename Ring>
+size_t rbReadFrom(Ring &ring, Stream &in, size_t max = (size_t) -1) {
+    size_t read = 0;
+
+    for (int segment = 0; (segment < 2) && (read < max); segment++) {
+        int available = in.available();
+        size_t len;
+        uint8_t *data = (uint8_t *) ring.beginWrite(len);
+
+        static_assert(sizeof(*ring.beginWrite(len)) == 1, "Elements must be bytes");
+        if (!data || (available <= 0))
+            break;
+
+        if (len > max - read)
+            len = max - read;
+        if (len > (size_t) available)
+            len = (size_t) available;
+
+        size_t accepted = in.readBytes((char *) data, len);
+        ring.commitWrite(accepted);
+        read += accepted;
+
+        if (accepted < len)
+            break;
+    }
+
+    return read;
+}
+#endif // ARDUINO
+
+
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+/**
+ * Write the contents of the buffer to a file descriptor with a single
+ * `writev()` call.
+ *
+ * @param ring Buffer of bytes.
+ * @param fd   File descriptor (file, pipe, socket, ...).
+ * @param max  Maximum number of bytes to write.
+ *
+ * @return number of bytes written and removed from the buffer, 0 if the
+ *         buffer is empty or -1 with `errno` set on error.
+ */
+template<typename Ring>
+ssize_t rbWriteFd(Ring &ring, int fd, size_t max = (size_t) -1) {
+    struct iovec iov[2];
+    int segments = 0;
+    size_t total = 0;
+
+    while ((segments < 2) && (total < max)) {
+        size_t len;
+        const void *data = ring.beginRead(len, total);
+
+        static_assert(sizeof(*ring.beginRead(len)) == 1, "Elements must be bytes");
+        if (!data)
+            break;
+
+        if (len > max - total)
+            len = max - total;
+
+        iov[segments].iov_base = const_cast<void *>(data);
+        iov[segments].iov_len = len;
+        segments++;
+        total += len;
+    }
+
+    if (!segments)
+        return 0;
+
+    ssize_t ret = writev(fd, iov, segments);
+    if (ret > 0)
+        ring.commitRead((size_t) ret);
+
+    return ret;
+}
+
+
+/**
+ * Read from a file descriptor into the free space of the buffer with a
+ * single `readv()` call.
+ *
+ * @param ring Buffer of bytes.
+ * @param fd   File descriptor (file, pipe, socket, ...).
+ * @param max  Maximum number of bytes to read.
+ *
+ * @return number of bytes read and added to the buffer, 0 if the buffer is
+ *         full or at the end of file, or -1 with `errno` set on error.
+ */
+template<typename Ring>
+ssize_t rbReadFd(Ring &ring, int fd, size_t max = (size_t) -1) {
+    struct iovec iov[2];
+    int segments = 0;
+    size_t total = 0;
+
+    while ((segments < 2) && (total < max)) {
+        size_t len;
+        void *data = ring.beginWrite(len, total);
+
+        static_assert(sizeof(*ring.beginWrite(len)) == 1, "Elements must be bytes");
+        if (!data)
+            break;
+
+        if (len > max - total)
+            len = max - total;
+
+        iov[segments].iov_base = data;
+        iov[segments].iov_len = len;
+        segments++;
+        total += len;
+    }
+
+    if (!segments)
+        return 0;
+
+    ssize_t ret = readv(fd, iov, segments);
+    if (ret > 0)
+        ring.commitWrite((size_t) ret);
+
+    return ret;
+}
+#endif
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef EM_RINGBUF_LOCK_CPP_H
+#define EM_RINGBUF_LOCK_CPP_H
+
+#include "RingBufHelpers.h"
+
+#if !defined(ARDUINO) && !defined(NORDIC_NRF5x) && \
+    (defined(__linux__) || defined(__APPLE__) || defined(_WIN32))
+    #include <mutex>
+    #define RB_HAS_STD_MUTEX 1
+#endif
+
+/*
+ * Locking policies of RingBufCPP, selecting how its critical sections are
+ * protected. A policy is a class with the methods
+ *
+ *     State lock() const;         // Enter the critical section
+ *     void unlock(State) const;   // Leave it, given the value from lock()
+ *     static constexpr bool interruptsOnly();
+ *
+ * where `interruptsOnly()` tells whether the policy only protects against
+ * interrupts on the same core (single-byte reads are then atomic and the
+ * state queries skip the lock). Locks must allow nesting of interrupt
+ * masking policies, as the variants built on RingBufCPP nest the critical
+ * sections. Stateless policies take no memory in the buffer.
+ */
+
+
+/**
+ * No protection, for buffers only accessed from a single context.
+ */
+struct RingBufNoLock {
+    typedef uint8_t State;
+
+    State lock() const {
+        return 0;
+    }
+
+    void unlock(State) const {}
+
+    static constexpr bool interruptsOnly() {
+        return true;
+    }
+};
+
+
+/**
+ * The protection of RB_ATOMIC_START/RB_ATOMIC_END on the platform, the
+ * default policy: interrupts disabled on AVR and ESP8266, the SoftDevice
+ * compatible critical region on nRF5 and no protection on other platforms.
+ */
+struct RingBufAtomicLock {
+#if defined(ARDUINO_ARCH_AVR)
+    typedef uint8_t State;
+
+    State lock() const {
+        State state = SREG;
+        cli();
+        return state;
+    }
+
+    void unlock(State state) const {
+        SREG = state;
+    }
+#elif defined(ARDUINO_ARCH_ESP8266)
+    typedef uint32_t State;
+
+    State lock() const {
+        return xt_rsil(15);
+    }
+
+    void unlock(State state) const {
+        xt_wsr_ps(state);
+    }
+#elif defined(NORDIC_NRF5x)
+    typedef uint8_t State;
+
+    State lock() const {
+        State nested = 0;
+        app_util_critical_region_enter(&nested);
+        return nested;
+    }
+
+    void unlock(State nested) const {
+        app_util_critical_region_exit(nested);
+    }
+#else
+    typedef uint8_t State;
+
+    State lock() const {
+        return 0;
+    }
+
+    void unlock(State) const {}
+#endif
+
+    static constexpr bool interruptsOnly() {
+        return true;
+    }
+};
+
+
+#if defined(__ARM_ARCH) && (__ARM_ARCH_PROFILE == 'M')
+/**
+ * Disables all interrupts on Cortex-M (PRIMASK), restoring the previous
+ * state when unlocking so it can be nested.
+ */
+struct RingBufIrqLock {
+    typedef uint32_t State;
+
+    State lock() const {
+        State primask;
+        __asm__ __volatile__("mrs %0, primask\n cpsid i" : "=r"(primask) :: "memory");
+        return primask;
+    }
+
+    void unlock(State primask) const {
+        __asm__ __volatile__("msr primask, %0" :: "r"(primask) : "memory");
+    }
+
+    static constexpr bool interruptsOnly() {
+        return true;
+    }
+};
+#endif
+
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+/**
+ * Masks only the interrupts with a priority value of `Priority` and above
+ * (lower or equal urgency) on Cortex-M3/M4/M7/M33 using BASEPRI, so that more
+ * urgent interrupts which do not access the buffer are never delayed. All
+ * contexts accessing the buffer must run at `Priority` or below.
+ *
+ * @tparam Priority     Priority of the most urgent interrupt accessing the
+ *                      buffer, as passed to `NVIC_SetPriority()`. Must not
+ *                      be 0, which cannot be masked with BASEPRI.
+ * @tparam PriorityBits Number of implemented priority bits (`__NVIC_PRIO_BITS`,
+ *                      3 on nRF52, 4 on STM32).
+ */
+template<uint8_t Priority, uint8_t PriorityBits = 3>
+struct RingBufBasepriLock {
+    static_assert(Priority > 0 && Priority < (1u << PriorityBits), "Invalid priority");
+
+    typedef uint32_t State;
+
+    State lock() const {
+        State basepri;
+        __asm__ __volatile__("mrs %0, basepri" : "=r"(basepri));
+        // Only raises the masking level, so it can be nested
+        __asm__ __volatile__("msr basepri_max, %0"
+                             :: "r"((uint32_t) Priority << (8 - PriorityBits)) : "memory");
+        return basepri;
+    }
+
+    void unlock(State basepri) const {
+        __asm__ __volatile__("msr basepri, %0" :: "r"(basepri) : "memory");
+    }
+
+    static constexpr bool interruptsOnly() {
+        return true;
+    }
+};
+#endif
+
+
+#ifdef INC_FREERTOS_H
+/**
+ * FreeRTOS critical section, usable from both tasks and interrupts. On the
+ * ESP32 it takes a spinlock shared by both cores, elsewhere it masks the
+ * interrupts up to `configMAX_SYSCALL_INTERRUPT_PRIORITY`. Include
+ * `FreeRTOS.h` and `task.h` before the library.
+ */
+class RingBufFreeRtosLock {
+public:
+#ifdef ESP_PLATFORM
+    typedef uint8_t State;
+
+    RingBufFreeRtosLock() {
+        portMUX_INITIALIZE(&_mux);
+    }
+
+    State lock() const {
+        portENTER_CRITICAL_SAFE(&_mux);
+        return 0;
+    }
+
+    void unlock(State) const {
+        portEXIT_CRITICAL_SAFE(&_mux);
+    }
+
+    static constexpr bool interruptsOnly() {
+        return false; // Accessed from both cores
+    }
+
+private:
+    mutable portMUX_TYPE _mux;
+#else
+    typedef UBaseType_t State;
+
+    State lock() const {
+        return taskENTER_CRITICAL_FROM_ISR();
+    }
+
+    void unlock(State state) const {
+        taskEXIT_CRITICAL_FROM_ISR(state);
+    }
+
+    static constexpr bool interruptsOnly() {
+        return true;
+    }
+#endif
+};
+#endif
+
+
+/**
+ * Spinlock for buffers shared between threads or cores. Must not be used
+ * between an interrupt and the code it interrupts on the same core, which
+ * would spin forever.
+ */
+class RingBufSpinLock {
+public:
+    typedef uint8_t State;
+
+    constexpr RingBufSpinLock() :
+            _locked(false) {
+    }
+
+    State lock() const {
+        while (__atomic_test_and_set(&_locked, __ATOMIC_ACQUIRE)) {
+            while (__atomic_load_n(&_locked, __ATOMIC_RELAXED)) {
+                // Wait without writing the shared cache line
+            }
+        }
+        return 0;
+    }
+
+    void unlock(State) const {
+        __atomic_clear(&_locked, __ATOMIC_RELEASE);
+    }
+
+    static constexpr bool interruptsOnly() {
+        return false;
+    }
+
+private:
+    mutable bool _locked;
+};
+
+
+#ifdef RB_HAS_STD_MUTEX
+/**
+ * `std::mutex` for buffers shared between threads on hosts.
+ */
+class RingBufMutexLock {
+public:
+    typedef uint8_t State;
+
+    State lock() const {
+        _mutex.lock();
+        return 0;
+    }
+
+    void unlock(State) const {
+        _mutex.unlock();
+    }
+
+    static constexpr bool interruptsOnly() {
+        return false;
+    }
+
+private:
+    mutable std::mutex _mutex;
+};
+#endif
+
+
+/**
+ * Holds the lock of a policy for the lifetime of the guard.
+ */
+template<typename LockPolicy>
+class RingBufLockGuard {
+public:
+
+    explicit RingBufLockGuard(const LockPolicy &policy) :
+            _policy(policy),
+            _state(policy.lock()) {
+    }
+
+    ~RingBufLockGuard() {
+        _policy.unlock(_state);
+    }
+
+    RingBufLockGuard(const RingBufLockGuard &) = delete;
+    RingBufLockGuard &operator=(const RingBufLockGuard &) = delete;
+
+private:
+    const LockPolicy &_policy;
+    typename LockPolicy::State _state;
+};
+
+#endif
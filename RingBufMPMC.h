@@ -0,0 +1,211 @@
+#ifndef EM_RINGBUF_MPMC_CPP_H
+#define EM_RINGBUF_MPMC_CPP_H
+
+#include "RingBufHelpers.h"
+
+/**
+ * A lock-free multi-producer/multi-consumer variant of RingBufCPP, for
+ * multi-core targets (ESP32, hosts) or multiple producing contexts which the
+ * interrupt masking of RingBufCPP does not protect against each other.
+ *
+ * Every slot carries a sequence number telling whether it is free for the
+ * producer of a given lap or holds an element for the consumer of that lap.
+ * Producers (and consumers) only contend on a compare-and-swap of the shared
+ * index, they never wait for each other: a context preempted in the middle
+ * of an operation can only make its own slot appear not yet written (or not
+ * yet freed) to the others.
+ *
+ * `_head` and `_tail` are placed on separate cache lines, see
+ * `RB_CACHE_LINE_SIZE`.
+ *
+ * Requires lock-free atomic operations on `size_t`, so it is not available on
+ * cores without compare-and-swap instructions (AVR, Cortex-M0).
+ *
+ * @tparam Type        Type of the elements being stored.
+ * @tparam MaxElements Maximum number of elements in this buffer, must be a
+ *                     power of two.
+ */
+template<typename Type, size_t MaxElements>
+class RingBufMPMC {
+    static_assert(MaxElements && !(MaxElements & (MaxElements - 1)),
+                  "MaxElements must be a power of two");
+    static_assert(__atomic_always_lock_free(sizeof(size_t), 0),
+                  "Lock-free atomics are not available on this platform");
+
+public:
+
+    RingBufMPMC() :
+            _head(0),
+            _tail(0) {
+        for (size_t i = 0; i < MaxElements; i++)
+            _slots[i].seq = i;
+    }
+
+    ~RingBufMPMC() {
+        for (size_t pos = _tail; pos != _head; pos++)
+            _slots[pos & (MaxElements - 1)].value.~Type();
+    }
+
+    /**
+     *  Add an element to the buffer. Can be called from any context.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        return emplace(obj);
+    }
+
+
+    /**
+     *  Add an element to the buffer by moving it. Can be called from any
+     *  context.
+     *
+     *  @param obj[in] The element to move into the buffer.
+     *
+     *  @return true on success.
+     */
+    bool add(Type &&obj) {
+        return emplace(rbMove(obj));
+    }
+
+
+    /**
+     *  Construct an element in place at the end of the buffer. Can be called
+     *  from any context.
+     *
+     *  @param args[in] Arguments forwarded to the constructor of the element.
+     *
+     *  @return true on success.
+     */
+    template<typename... Args>
+    bool emplace(Args &&... args) {
+        size_t pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        Slot *slot;
+
+        for (;;) {
+            slot = &_slots[pos & (MaxElements - 1)];
+            size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            ptrdiff_t diff = (ptrdiff_t) (seq - pos);
+
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&_head, &pos, pos + 1, true,
+                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            }
+            else if (diff < 0) {
+                return false; // Slot still holds an element of the previous lap
+            }
+            else {
+                pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+            }
+        }
+
+        new (&slot->value, RingBufPlacement())
+                Type(rbForward<Args>(args)...);
+        __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+
+    /**
+     * Remove last element from buffer, and move it to destination. Can be
+     * called from any context.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be moved.
+     *
+     * @return true on success.
+     */
+    bool pull(Type *dest) {
+        size_t pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        Slot *slot;
+
+        for (;;) {
+            slot = &_slots[pos & (MaxElements - 1)];
+            size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            ptrdiff_t diff = (ptrdiff_t) (seq - (pos + 1));
+
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&_tail, &pos, pos + 1, true,
+                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            }
+            else if (diff < 0) {
+                return false; // Slot not written yet in this lap
+            }
+            else {
+                pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+            }
+        }
+
+        *dest = rbMove(slot->value);
+        slot->value.~Type();
+        __atomic_store_n(&slot->seq, pos + MaxElements, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+
+    /**
+     * @return true if buffer is full. The result can already be outdated
+     *         when returned if other contexts are accessing the buffer.
+     */
+    bool isFull() const {
+        return numElements() >= MaxElements;
+    }
+
+
+    /**
+     * @return number of elements currently in buffer. The result can already
+     *         be outdated when returned if other contexts are accessing the
+     *         buffer.
+     */
+    size_t numElements() const {
+        size_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        size_t num = __atomic_load_n(&_head, __ATOMIC_ACQUIRE) - tail;
+
+        // Head can advance in between the two loads, never below the tail
+        return (num > MaxElements) ? MaxElements : num;
+    }
+
+
+    /**
+     * @return true if buffer is empty. The result can already be outdated
+     *         when returned if other contexts are accessing the buffer.
+     */
+    bool isEmpty() const {
+        return !numElements();
+    }
+
+protected:
+    struct Slot {
+        Slot() {}
+        ~Slot() {}
+
+        /**
+         * Equal to the position for which the slot is free to be written,
+         * position + 1 once the written element can be read.
+         */
+        size_t seq;
+
+        /** Element, in a union so that it is only constructed when added. */
+        union {
+            Type value;
+        };
+    };
+
+
+    RB_CACHE_ALIGNED Slot _slots[MaxElements];
+
+    /** Position (free running) of the next element to write. */
+    RB_CACHE_ALIGNED size_t _head;
+    /** Position (free running) of the next element to read. */
+    RB_CACHE_ALIGNED size_t _tail;
+private:
+
+};
+
+#endif
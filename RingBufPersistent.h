@@ -0,0 +1,349 @@
+#ifndef EM_RINGBUF_PERSISTENT_CPP_H
+#define EM_RINGBUF_PERSISTENT_CPP_H
+
+#include "RingBufHelpers.h"
+
+/*
+ * Attribute placing a variable in RAM which is not initialized at startup,
+ * so that its contents survive a reset (watchdog, brown-out, crash). The
+ * `.noinit` section is provided by the default linker scripts of AVR and of
+ * the nRF5 SDK, on other platforms define it before including the library
+ * (e.g. as `RTC_NOINIT_ATTR` on the ESP32).
+ */
+#ifndef RB_NOINIT
+    #if defined(ARDUINO_ARCH_AVR) || defined(NORDIC_NRF5x)
+        #define RB_NOINIT __attribute__((section(".noinit")))
+    #else
+        #define RB_NOINIT
+    #endif
+#endif
+
+/**
+ * A ring (FIFO) buffer surviving resets when placed in retained RAM, e.g.
+ * for crash telemetry:
+ *
+ *     RB_NOINIT RingBufPersistent<Event, 32> events;
+ *
+ *     void setup() {
+ *         events.recover(); // Resume with the events from before the reset
+ *     }
+ *
+ * It has no constructor, so that the startup code leaves its memory intact.
+ * `recover()` must be called before any other method, it validates the state
+ * in O(1) with a magic word and a CRC of the header instead of scanning the
+ * elements. The header is kept in two copies written alternately, each after
+ * the element it describes, so a reset in the middle of any operation leaves
+ * the buffer in the state before or after the operation. The only exception
+ * is `addOverwrite()` on a full buffer, which first removes the oldest
+ * element and then adds the new one, a reset in between leaves the buffer
+ * with the oldest element removed.
+ *
+ * The same concurrency protection as RingBufCPP is used, every modification
+ * additionally calculates a CRC16 of the header in the critical section.
+ *
+ * @tparam Type        Type of the elements being stored, must be trivially
+ *                     copyable and trivially default constructible to be
+ *                     valid after a reset.
+ * @tparam MaxElements Maximum number of elements in this buffer.
+ */
+template<typename Type, size_t MaxElements>
+class RingBufPersistent {
+    static_assert(RB_IS_TRIVIALLY_COPYABLE(Type), "Type must be trivially copyable");
+    static_assert(RB_IS_TRIVIALLY_CONSTRUCTIBLE(Type), "Type must be trivially default constructible");
+
+public:
+
+    /**
+     * Resume with the contents from before the reset if they are valid,
+     * otherwise start with an empty buffer.
+     *
+     * @return true if the contents were recovered, false if the buffer was
+     *         reset (first power-up, different firmware, corruption).
+     */
+    bool recover() {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                bool valid0 = isValid(_headers[0]);
+                bool valid1 = isValid(_headers[1]);
+
+                if (valid0 && valid1)
+                    _active = isNewer(_headers[1], _headers[0]) ? 1 : 0;
+                else
+                    _active = valid1 ? 1 : 0;
+
+                ret = valid0 || valid1;
+                if (!ret)
+                    clear();
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove all elements from the buffer.
+     */
+    void reset() {
+        RB_ATOMIC_START
+            {
+                clear();
+            }
+        RB_ATOMIC_END
+    }
+
+
+    /**
+     *  Add an element to the buffer.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                const Header &header = _headers[_active];
+
+                if (header.numElements < MaxElements) {
+                    _buf[header.head] = obj;
+                    commit(Index::add(header.head, 1), header.numElements + 1);
+
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     *  Add an element to the buffer, overwriting the oldest element if the
+     *  buffer is full, to keep the most recent elements.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true if the oldest element was overwritten, false if there
+     *          was room for the element.
+     */
+    bool addOverwrite(const Type &obj) {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                size_t head = _headers[_active].head;
+                size_t num = _headers[_active].numElements;
+
+                ret = num >= MaxElements;
+                if (ret) {
+                    // The oldest element is dropped before its slot is reused
+                    num--;
+                    commit(head, num);
+                }
+
+                _buf[head] = obj;
+                commit(Index::add(head, 1), num + 1);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove last element from buffer, and copy it to destination.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be copied.
+     *
+     * @return true on success.
+     */
+    bool pull(Type *dest) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                const Header &header = _headers[_active];
+
+                if (header.numElements) {
+                    *dest = _buf[getTail(header)];
+                    commit(header.head, header.numElements - 1);
+
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Peek at n'th element in the buffer.
+     *
+     * @param num Index of the element to peek at. As this is FIFO buffer, the
+     *            oldest element in the buffer is always at index 0 and the
+     *            last added one is at the index `numElements() - 1`.
+     *
+     * @return A pointer to the num'th element or `nullptr` if there is less
+     *         elements currently in the buffer than provided index.
+     */
+    Type *peek(size_t num) {
+        Type *ret = nullptr;
+
+        RB_ATOMIC_START
+            {
+                const Header &header = _headers[_active];
+
+                if (num < header.numElements)
+                    ret = &_buf[Index::add(getTail(header), num)];
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return true if buffer is full.
+     */
+    bool isFull() const {
+        return numElements() >= MaxElements;
+    }
+
+
+    /**
+     * @return number of elements currently in buffer.
+     */
+    size_t numElements() const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _headers[_active].numElements;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return true if buffer is empty.
+     */
+    bool isEmpty() const {
+        return !numElements();
+    }
+
+protected:
+    typedef RingBufIndex<MaxElements> Index;
+    typedef typename RingBufIndexType<MaxElements>::type IndexType;
+
+    static const uint32_t Magic = 0x52427046ul; // "RBpF"
+
+    struct Header {
+        uint32_t magic;
+        /** Incremented on every write, the copy with the higher one is used. */
+        uint16_t seq;
+        /** Index of the next element to write. */
+        IndexType head;
+        IndexType numElements;
+        /** CRC of the other fields and of the buffer layout. */
+        uint16_t crc;
+    };
+
+
+    /**
+     * CRC-16/CCITT of the header fields, also covering the layout of the
+     * buffer so that a firmware with a different layout does not recover it.
+     */
+    static uint16_t checksum(const Header &header) {
+        uint16_t crc = 0xFFFF;
+        uint32_t layout[2] = { (uint32_t) MaxElements, (uint32_t) sizeof(Type) };
+
+        crc = crc16(crc, &header.magic, sizeof(header.magic));
+        crc = crc16(crc, &header.seq, sizeof(header.seq));
+        crc = crc16(crc, &header.head, sizeof(header.head));
+        crc = crc16(crc, &header.numElements, sizeof(header.numElements));
+        return crc16(crc, layout, sizeof(layout));
+    }
+
+
+    static uint16_t crc16(uint16_t crc, const void *data, size_t len) {
+        const uint8_t *bytes = (const uint8_t *) data;
+
+        while (len--) {
+            crc ^= (uint16_t) (*bytes++ << 8);
+            for (uint8_t bit = 0; bit < 8; bit++)
+                crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+        }
+
+        return crc;
+    }
+
+
+    static bool isValid(const Header &header) {
+        return (header.magic == Magic) &&
+               (header.head < MaxElements) &&
+               (header.numElements <= MaxElements) &&
+               (header.crc == checksum(header));
+    }
+
+
+    /** @return true if `a` was written after `b`. */
+    static bool isNewer(const Header &a, const Header &b) {
+        return (uint16_t) (a.seq - b.seq) < 0x8000;
+    }
+
+
+    static size_t getTail(const Header &header) {
+        return Index::add(header.head, MaxElements - header.numElements);
+    }
+
+
+    /**
+     * Writes the new state to the inactive header and activates it, must be
+     * called from within the critical section after the elements are written.
+     */
+    void commit(size_t head, size_t numElements) {
+        const Header &current = _headers[_active];
+        uint8_t next = _active ^ 1;
+        Header header;
+
+        header.magic = Magic;
+        header.seq = (uint16_t) (current.seq + 1);
+        header.head = (IndexType) head;
+        header.numElements = (IndexType) numElements;
+        header.crc = checksum(header);
+
+        RB_COMPILER_BARRIER(); // Elements are in memory before the header
+        _headers[next] = header;
+        RB_COMPILER_BARRIER();
+        _active = next;
+    }
+
+
+    /** Invalidates both headers and writes an empty state. */
+    void clear() {
+        _headers[0].magic = 0;
+        _headers[1].magic = 0;
+        _headers[1].seq = 0;
+        _active = 1;
+        commit(0, 0);
+    }
+
+
+    Type _buf[MaxElements];
+    Header _headers[2];
+    /** Index of the valid header with the current state. */
+    uint8_t _active;
+private:
+
+};
+
+#endif
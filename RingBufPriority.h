@@ -0,0 +1,188 @@
+#ifndef EM_RINGBUF_PRIORITY_CPP_H
+#define EM_RINGBUF_PRIORITY_CPP_H
+
+#include "RingBufCPP.h"
+
+/**
+ * A set of RingBufCPP buffers (lanes) of different priorities, e.g. for
+ * urgent, normal and bulk events. A bitmask of the non-empty lanes is kept
+ * together with the lanes, so the oldest element of the highest priority
+ * lane is found with a single count-leading-zeros instruction (where the
+ * core has one) and one critical section, regardless of the number of lanes.
+ *
+ * @tparam Type        Type of the elements being stored.
+ * @tparam MaxElements Maximum number of elements in every lane.
+ * @tparam Lanes       Number of lanes, lane 0 having the highest priority.
+ *                     At most the number of bits of `unsigned int` (16 on
+ *                     AVR, 32 on other platforms).
+ */
+template<typename Type, size_t MaxElements, size_t Lanes>
+class RingBufPriority {
+    typedef unsigned int Mask;
+    static const size_t MaskBits = sizeof(Mask) * 8;
+
+    static_assert(Lanes > 0 && Lanes <= MaskBits, "Unsupported number of lanes");
+
+public:
+
+    RingBufPriority() :
+            _nonEmpty(0) {
+    }
+
+    /**
+     *  Add an element to the given lane.
+     *
+     *  @param lane    Index of the lane, less than `Lanes`.
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(size_t lane, const Type &obj) {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _lanes[lane].add(obj);
+                if (ret)
+                    _nonEmpty |= bit(lane);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     *  Add an element to the given lane by moving it.
+     *
+     *  @param lane    Index of the lane, less than `Lanes`.
+     *  @param obj[in] The element to move into the buffer.
+     *
+     *  @return true on success.
+     */
+    bool add(size_t lane, Type &&obj) {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _lanes[lane].add(rbMove(obj));
+                if (ret)
+                    _nonEmpty |= bit(lane);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove the oldest element of the highest priority non-empty lane, and
+     * move it to destination.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be moved.
+     * @param lane[out] If not `nullptr`, set to the index of the lane from
+     *                  which the element was removed.
+     *
+     * @return true on success, false if all lanes are empty.
+     */
+    bool pullHighest(Type *dest, size_t *lane = nullptr) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (_nonEmpty) {
+                    size_t highest = (size_t) __builtin_clz(_nonEmpty);
+
+                    ret = pullFrom(highest, dest);
+                    if (lane)
+                        *lane = highest;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove the oldest element of the given lane, and move it to
+     * destination.
+     *
+     * @param lane      Index of the lane, less than `Lanes`.
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be moved.
+     *
+     * @return true on success, false if the lane is empty.
+     */
+    bool pull(size_t lane, Type *dest) {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = pullFrom(lane, dest);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @param lane Index of the lane, less than `Lanes`.
+     *
+     * @return number of elements currently in the lane.
+     */
+    size_t numElements(size_t lane) const {
+        return _lanes[lane].numElements();
+    }
+
+
+    /**
+     * @return true if all lanes are empty.
+     */
+    bool isEmpty() const {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = !_nonEmpty;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+protected:
+    /**
+     * @return bit of the lane in the mask of non-empty lanes, lane 0 being
+     *         the most significant bit so that counting the leading zeros
+     *         yields the index of the highest priority lane.
+     */
+    static Mask bit(size_t lane) {
+        return ((Mask) 1 << (MaskBits - 1)) >> lane;
+    }
+
+
+    /**
+     * Removes the oldest element of the lane, must be called from within
+     * the critical section.
+     */
+    bool pullFrom(size_t lane, Type *dest) {
+        bool ret = _lanes[lane].pull(dest);
+
+        if (_lanes[lane].isEmpty())
+            _nonEmpty &= ~bit(lane);
+
+        return ret;
+    }
+
+
+    RingBufCPP<Type, MaxElements> _lanes[Lanes];
+    /** Mask of lanes containing elements, see `bit()`. */
+    Mask _nonEmpty;
+private:
+
+};
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef EM_RINGBUF_RECORDS_CPP_H
+#define EM_RINGBUF_RECORDS_CPP_H
+
+#include "RingBufHelpers.h"
+
+/**
+ * A ring (FIFO) buffer of variable-length records (log messages, packets,
+ * ...), with the same concurrency protection as RingBufCPP. Records are
+ * stored back to back with a length prefix, so no space is wasted padding
+ * them to the maximum size.
+ *
+ * Every record is stored contiguously: if a record does not fit before the
+ * end of the array, the remaining bytes are skipped (marked as such if there
+ * is room for a length prefix) and the record is stored at the start.
+ * Records can therefore be accessed in place with `front()`, the returned
+ * data is not aligned.
+ *
+ * @tparam MaxBytes Size of the underlying array in bytes, including the
+ *                  2 byte length prefix of every record.
+ */
+template<size_t MaxBytes>
+class RingBufRecords {
+    static_assert(MaxBytes > 2, "MaxBytes must be larger than the length prefix");
+
+public:
+
+    RingBufRecords() :
+            _head(0),
+            _tail(0),
+            _used(0),
+            _numRecords(0) {
+    }
+
+    /**
+     * Add a record to the buffer.
+     *
+     * @param data[in] Content of the record.
+     * @param len      Length of the record in bytes, less than 0xFFFF.
+     *
+     * @return true on success, false if there is not enough contiguous space
+     *         in the buffer.
+     */
+    bool push(const void *data, size_t len) {
+        bool ret = false;
+
+        if (len >= SkipMarker)
+            return false;
+
+        size_t size = LengthBytes + len;
+
+        RB_ATOMIC_START
+            {
+                if (!_numRecords) {
+                    // Start at the beginning to have the most contiguous space
+                    _head = 0;
+                    _tail = 0;
+                    _used = 0;
+                }
+
+                size_t room = MaxBytes - _head;
+                size_t skip = (size > room) ? room : 0;
+
+                if (_used + skip + size <= MaxBytes) {
+                    if (skip) {
+                        if (skip >= LengthBytes)
+                            writeLength(_head, SkipMarker);
+                        _used += skip;
+                        _head = 0;
+                    }
+
+                    writeLength(_head, len);
+                    memcpy(&_buf[_head + LengthBytes], data, len);
+                    _head = wrap(_head + size);
+                    _used += size;
+                    _numRecords++;
+
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Access the oldest record in place. It stays valid until it is removed
+     * by calling `pop()`. Must only be called by a single consumer.
+     *
+     * @param len[out] Length of the record in bytes.
+     *
+     * @return A pointer to the content of the oldest record or `nullptr` if
+     *         the buffer is empty.
+     */
+    const uint8_t *front(size_t &len) const {
+        const uint8_t *ret = nullptr;
+
+        RB_ATOMIC_START
+            {
+                if (_numRecords) {
+                    size_t pos = recordStart();
+
+                    len = readLength(pos);
+                    ret = &_buf[pos + LengthBytes];
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove the oldest record from the buffer.
+     *
+     * @return true on success, false if the buffer is empty.
+     */
+    bool pop() {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (_numRecords) {
+                    size_t pos = recordStart();
+
+                    if (pos != _tail)
+                        _used -= MaxBytes - _tail; // Skipped end of the array
+
+                    size_t size = LengthBytes + readLength(pos);
+                    _tail = wrap(pos + size);
+                    _used -= size;
+                    _numRecords--;
+
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return number of records currently in buffer.
+     */
+    size_t numRecords() const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _numRecords;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return number of bytes currently used, including the length prefixes
+     *         and the skipped bytes at the end of the array.
+     */
+    size_t numBytes() const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _used;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return true if buffer is empty.
+     */
+    bool isEmpty() const {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = !_numRecords;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+protected:
+    typedef typename RingBufIndexType<MaxBytes>::type IndexType;
+
+    /** Size of the length prefix of every record. */
+    static const size_t LengthBytes = 2;
+    /** Length prefix marking the bytes until the end of the array as skipped. */
+    static const size_t SkipMarker = 0xFFFF;
+
+
+    /**
+     * Wraps the index around the end of the array.
+     *
+     * @param index Index at most `MaxBytes`.
+     *
+     * @return index of the byte in array.
+     */
+    static size_t wrap(size_t index) {
+        return (index >= MaxBytes) ? (index - MaxBytes) : index;
+    }
+
+
+    size_t readLength(size_t index) const {
+        uint16_t len;
+
+        memcpy(&len, &_buf[index], sizeof(len));
+        return len;
+    }
+
+
+    void writeLength(size_t index, size_t len) {
+        uint16_t value = (uint16_t) len;
+
+        memcpy(&_buf[index], &value, sizeof(value));
+    }
+
+
+    /**
+     * Calculates the index of the oldest record, skipping the end of the
+     * array if the record was stored at the start. Must be called from within
+     * the critical section with at least one record in the buffer.
+     *
+     * @return index of the length prefix of the record in array.
+     */
+    size_t recordStart() const {
+        if ((MaxBytes - _tail < LengthBytes) || (readLength(_tail) == SkipMarker))
+            return 0;
+        return _tail;
+    }
+
+
+    uint8_t _buf[MaxBytes];
+
+    /** Index of the next byte to write. */
+    IndexType _head;
+    /** Index of the oldest record (or of the skipped bytes before it). */
+    IndexType _tail;
+    /** Number of bytes used, including the skipped ones. */
+    IndexType _used;
+    IndexType _numRecords;
+private:
+
+};
+
+#endif
@@ -0,0 +1,445 @@
+#ifndef EM_RINGBUF_SPSC_CPP_H
+#define EM_RINGBUF_SPSC_CPP_H
+
+#include "RingBufHelpers.h"
+
+/**
+ * A lock-free single-producer/single-consumer variant of RingBufCPP.
+ *
+ * The producer (e.g. an ISR) only ever writes `_head` and the consumer (e.g.
+ * `loop()`) only ever writes `_tail`, so no critical sections are required -
+ * interrupts stay enabled during every operation. This is only safe if there
+ * is exactly one context calling the producer methods (`add()`) and exactly
+ * one context calling the consumer methods (`pull()`, `peek()`). The state
+ * queries can be called from either side.
+ *
+ * Both indices run over `[0, 2 * MaxElements)`, which makes it possible to
+ * distinguish a full buffer from an empty one without sacrificing a slot.
+ * See `RB_CACHE_LINE_SIZE` and `RB_CACHED_INDICES` for the layout options
+ * preventing false sharing between the producer and the consumer on
+ * multi-core targets.
+ *
+ * @tparam Type        Type of the elements being stored.
+ * @tparam MaxElements Maximum number of elements in this buffer. Note that
+ *                     the allocated memory size will be at least
+ *                     `MaxElements * sizeof(Type)`.
+ */
+template<typename Type, size_t MaxElements>
+class RingBufSPSC {
+    static_assert(MaxElements > 0, "MaxElements must be at least 1");
+
+public:
+
+    RingBufSPSC() :
+            _head(0),
+#if RB_CACHED_INDICES
+            _tailCache(0),
+#endif
+            _tail(0)
+#if RB_CACHED_INDICES
+            , _headCache(0)
+#endif
+    {
+    }
+
+    /**
+     *  Add an element to the buffer. Must only be called by the producer.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        size_t head = _head;
+
+        if (!freeSpace(head, 1))
+            return false;
+
+        _buf[position(head)] = obj;
+        RB_STORE_RELEASE(_head, Counter::add(head, 1));
+
+        return true;
+    }
+
+
+    /**
+     * Remove last element from buffer, and copy it to destination. Must only
+     * be called by the consumer.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be copied.
+     *
+     * @return true on success.
+     */
+    bool pull(Type *dest) {
+        size_t tail = _tail;
+
+        if (!available(tail, 1))
+            return false;
+
+        *dest = _buf[position(tail)];
+        RB_STORE_RELEASE(_tail, Counter::add(tail, 1));
+
+        return true;
+    }
+
+
+    /**
+     * Add multiple elements to the buffer. The elements are copied in at most
+     * two contiguous blocks and the index is updated only once. Must only be
+     * called by the producer.
+     *
+     * @param src[in] Array of elements to add.
+     * @param num     Number of elements in the `src` array.
+     *
+     * @return number of elements added, less than `num` if the buffer
+     *         became full.
+     */
+    size_t addMany(const Type *src, size_t num) {
+        size_t head = _head;
+        size_t free = freeSpace(head, num);
+
+        if (num > free)
+            num = free;
+
+        size_t pos = position(head);
+        size_t first = MaxElements - pos;
+        if (first > num)
+            first = num;
+
+        Copy::copy(&_buf[pos], src, first);
+        Copy::copy(_buf, src + first, num - first);
+        RB_STORE_RELEASE(_head, Counter::add(head, num));
+
+        return num;
+    }
+
+
+    /**
+     * Remove multiple oldest elements from the buffer and copy them to
+     * destination. The elements are copied in at most two contiguous blocks
+     * and the index is updated only once. Must only be called by the
+     * consumer.
+     *
+     * @param dest[out] Array to which removed elements will be copied.
+     * @param num       Maximum number of elements to remove, `dest` must be
+     *                  large enough to hold this many elements.
+     *
+     * @return number of elements removed, less than `num` if the buffer
+     *         became empty.
+     */
+    size_t pullMany(Type *dest, size_t num) {
+        size_t tail = _tail;
+        size_t used = available(tail, num);
+
+        if (num > used)
+            num = used;
+
+        size_t pos = position(tail);
+        size_t first = MaxElements - pos;
+        if (first > num)
+            first = num;
+
+        Copy::copy(dest, &_buf[pos], first);
+        Copy::copy(dest + first, _buf, num - first);
+        RB_STORE_RELEASE(_tail, Counter::add(tail, num));
+
+        return num;
+    }
+
+
+    /**
+     * Reserve space for adding elements directly into the underlying array,
+     * e.g. by DMA or by constructing them in place. The reserved elements are
+     * added to the buffer only by calling `commitWrite()`. Must only be
+     * called by the producer.
+     *
+     * @param contiguous[out] Number of elements which can be written to the
+     *                        returned location.
+     * @param offset          Number of free elements to skip. Use
+     *                        `offset = contiguous` of the first call to
+     *                        access the free elements at the start of the
+     *                        array.
+     *
+     * @return A pointer to the first free element (after `offset`) in the
+     *         array or `nullptr` if there are not more than `offset` free
+     *         elements.
+     */
+    Type *beginWrite(size_t &contiguous, size_t offset = 0) {
+        size_t head = _head;
+        size_t free = freeSpace(head, MaxElements);
+
+        contiguous = 0;
+        if (offset >= free)
+            return nullptr;
+
+        size_t pos = Index::add(position(head), offset);
+
+        contiguous = MaxElements - pos;
+        if (contiguous > free - offset)
+            contiguous = free - offset;
+
+        return &_buf[pos];
+    }
+
+
+    /**
+     * Add elements previously written to the location returned by
+     * `beginWrite()` to the buffer. Must only be called by the producer.
+     *
+     * @param num Number of elements written, at most the number of
+     *            contiguous elements reported by `beginWrite()`.
+     *
+     * @return number of elements added.
+     */
+    size_t commitWrite(size_t num) {
+        size_t head = _head;
+        size_t free = freeSpace(head, num);
+
+        if (num > free)
+            num = free;
+
+        RB_STORE_RELEASE(_head, Counter::add(head, num));
+
+        return num;
+    }
+
+
+    /**
+     * Access the oldest elements directly in the underlying array, without
+     * copying them out. The elements stay in the buffer until they are
+     * released by calling `commitRead()`. Must only be called by the
+     * consumer.
+     *
+     * @param contiguous[out] Number of elements which can be read from the
+     *                        returned location.
+     * @param offset          Index of the first element to access, as used
+     *                        by `peek()`. Use `offset = contiguous` of the
+     *                        first call to access the elements after the
+     *                        end of the array.
+     *
+     * @return A pointer to the oldest element (at `offset`) in the array or
+     *         `nullptr` if there are not more than `offset` elements in the
+     *         buffer.
+     */
+    const Type *beginRead(size_t &contiguous, size_t offset = 0) {
+        size_t tail = _tail;
+        size_t used = available(tail, MaxElements);
+
+        contiguous = 0;
+        if (offset >= used)
+            return nullptr;
+
+        size_t pos = Index::add(position(tail), offset);
+
+        contiguous = MaxElements - pos;
+        if (contiguous > used - offset)
+            contiguous = used - offset;
+
+        return &_buf[pos];
+    }
+
+
+    /**
+     * Remove elements previously read from the location returned by
+     * `beginRead()` from the buffer. Must only be called by the consumer.
+     *
+     * @param num Number of elements read, at most the number of contiguous
+     *            elements reported by `beginRead()`.
+     *
+     * @return number of elements removed.
+     */
+    size_t commitRead(size_t num) {
+        size_t tail = _tail;
+        size_t used = available(tail, num);
+
+        if (num > used)
+            num = used;
+
+        RB_STORE_RELEASE(_tail, Counter::add(tail, num));
+
+        return num;
+    }
+
+
+    /**
+     * Process the oldest elements in place and remove them from the buffer.
+     * The number of elements to process is determined once at the start,
+     * elements are passed directly from the underlying array to `fn` (in at
+     * most two contiguous segments) and removed with a single index update
+     * at the end. Elements added meanwhile are left for the next call. Must
+     * only be called by the consumer.
+     *
+     * @param fn  Function or functor called as `fn(const Type &)` for every
+     *            element, from the oldest to the newest one.
+     * @param max Maximum number of elements to process.
+     *
+     * @return number of elements processed and removed.
+     */
+    template<typename Function>
+    size_t drain(Function fn, size_t max = (size_t) -1) {
+        size_t tail = _tail;
+        size_t num = available(tail, MaxElements);
+
+        if (num > max)
+            num = max;
+
+        size_t pos = position(tail);
+        size_t first = MaxElements - pos;
+        if (first > num)
+            first = num;
+
+        for (size_t i = 0; i < first; i++)
+            fn(static_cast<const Type &>(_buf[pos + i]));
+        for (size_t i = 0; i < num - first; i++)
+            fn(static_cast<const Type &>(_buf[i]));
+
+        RB_STORE_RELEASE(_tail, Counter::add(tail, num));
+
+        return num;
+    }
+
+
+    /**
+     * Peek at n'th element in the buffer. Must only be called by the
+     * consumer, the returned element stays valid until it is pulled.
+     *
+     * @param num Index of the element to peek at. As this is FIFO buffer, the
+     *            oldest element in the buffer is always at index 0 and the
+     *            last added one is at the index `numElements() - 1`.
+     *
+     * @return A pointer to the num'th element or `nullptr` if there is less
+     *         elements currently in the buffer than provided index.
+     */
+    Type *peek(size_t num) {
+        size_t tail = _tail;
+
+        if (num >= available(tail, num + 1))
+            return nullptr;
+
+        return &_buf[Index::add(position(tail), num)];
+    }
+
+
+    /**
+     * @return true if buffer is full.
+     */
+    bool isFull() const {
+        return numElements() >= MaxElements;
+    }
+
+
+    /**
+     * @return number of elements currently in buffer.
+     */
+    size_t numElements() const {
+        return count(RB_LOAD_ACQUIRE(_head), RB_LOAD_ACQUIRE(_tail));
+    }
+
+
+    /**
+     * @return true if buffer is empty.
+     */
+    bool isEmpty() const {
+        return !numElements();
+    }
+
+protected:
+    typedef RingBufIndex<MaxElements> Index;
+    typedef RingBufIndex<2 * MaxElements> Counter;
+    typedef RingBufCopy<Type> Copy;
+    typedef typename RingBufIndexType<2 * MaxElements - 1>::type IndexType;
+
+
+    /**
+     * Calculates the number of elements between the two indices.
+     *
+     * @return number of elements.
+     */
+    static size_t count(size_t head, size_t tail) {
+        return Counter::add(head, 2 * MaxElements - tail);
+    }
+
+
+    /**
+     * Calculates the number of free elements from the producer's point of
+     * view, re-reading the consumer's index only if the cached copy does not
+     * indicate enough free space.
+     *
+     * @param head   Current value of `_head`.
+     * @param wanted Number of free elements the producer needs.
+     *
+     * @return number of free elements.
+     */
+    size_t freeSpace(size_t head, size_t wanted) {
+#if RB_CACHED_INDICES
+        size_t free = MaxElements - count(head, _tailCache);
+        if (free >= wanted)
+            return free;
+
+        _tailCache = RB_LOAD_ACQUIRE(_tail);
+        return MaxElements - count(head, _tailCache);
+#else
+        (void) wanted;
+        return MaxElements - count(head, RB_LOAD_ACQUIRE(_tail));
+#endif
+    }
+
+
+    /**
+     * Calculates the number of elements from the consumer's point of view,
+     * re-reading the producer's index only if the cached copy does not
+     * indicate enough elements.
+     *
+     * @param tail   Current value of `_tail`.
+     * @param wanted Number of elements the consumer needs.
+     *
+     * @return number of elements.
+     */
+    size_t available(size_t tail, size_t wanted) {
+#if RB_CACHED_INDICES
+        size_t used = count(_headCache, tail);
+        if (used >= wanted)
+            return used;
+
+        _headCache = RB_LOAD_ACQUIRE(_head);
+        return count(_headCache, tail);
+#else
+        (void) wanted;
+        return count(RB_LOAD_ACQUIRE(_head), tail);
+#endif
+    }
+
+
+    /**
+     * Converts the index in range `[0, 2 * MaxElements)` to the index of the
+     * element in the array.
+     *
+     * @return index of the element in array.
+     */
+    static size_t position(size_t index) {
+        return Index::add(index, 0);
+    }
+
+
+    /** Underlying array. */
+    Type _buf[MaxElements];
+
+    /** Index of the next element to write, owned by the producer. */
+    RB_CACHE_ALIGNED IndexType _head;
+#if RB_CACHED_INDICES
+    /** Producer's copy of `_tail`, never ahead of the actual value. */
+    IndexType _tailCache;
+#endif
+
+    /** Index of the next element to read, owned by the consumer. */
+    RB_CACHE_ALIGNED IndexType _tail;
+#if RB_CACHED_INDICES
+    /** Consumer's copy of `_head`, never ahead of the actual value. */
+    IndexType _headCache;
+#endif
+private:
+
+};
+
+#endif
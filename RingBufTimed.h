@@ -0,0 +1,237 @@
+#ifndef EM_RINGBUF_TIMED_CPP_H
+#define EM_RINGBUF_TIMED_CPP_H
+
+#include "RingBufCPP.h"
+
+/**
+ * Element of RingBufTimed, an element with its timestamp.
+ */
+template<typename Type, typename StampType>
+struct RingBufTimedEntry {
+    StampType timestamp;
+    Type value;
+};
+
+
+/**
+ * A RingBufCPP of timestamped elements (e.g. events captured in ISRs with
+ * `millis()`), kept sorted by their monotonic timestamps so that the elements
+ * of a time window are found by a binary search within one critical section
+ * instead of peeking at the elements one by one.
+ *
+ * Timestamps are compared relative to the oldest element in the buffer, so
+ * the timestamp counter may wrap around. The elements in the buffer and the
+ * queried times must span less than half of the `StampType` range (24 days
+ * of `millis()` with `uint32_t`). Set `StampType` to `uint16_t` (or even
+ * `uint8_t`) to store only the lower bits of the timestamps and save RAM if
+ * the span of the elements allows it (32 seconds of `millis()`).
+ *
+ * The stored entries can not be modified in place, as changing a timestamp
+ * would break the order the searches rely on, so `peek()` only gives read
+ * access.
+ *
+ * @tparam Type        Type of the elements being stored.
+ * @tparam MaxElements Maximum number of elements in this buffer.
+ * @tparam StampType   Unsigned type in which the timestamps are stored.
+ */
+template<typename Type, size_t MaxElements, typename StampType = uint32_t>
+class RingBufTimed : protected RingBufCPP<RingBufTimedEntry<Type, StampType>, MaxElements> {
+public:
+    typedef RingBufTimedEntry<Type, StampType> Entry;
+
+protected:
+    typedef RingBufCPP<Entry, MaxElements> Base;
+
+public:
+
+    /**
+     *  Add an element to the buffer.
+     *
+     *  @param obj[in]   The element to add.
+     *  @param timestamp Timestamp of the element, truncated to `StampType`.
+     *
+     *  @return true on success, false if the buffer is full or the timestamp
+     *          is earlier than the one of the newest element.
+     */
+    bool add(const Type &obj, uint32_t timestamp) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (isMonotonic((StampType) timestamp))
+                    ret = Base::add(entry(obj, timestamp));
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     *  Add an element to the buffer, overwriting the oldest element if the
+     *  buffer is full.
+     *
+     *  @param obj[in]   The element to add.
+     *  @param timestamp Timestamp of the element, truncated to `StampType`.
+     *
+     *  @return true on success, false if the timestamp is earlier than the
+     *          one of the newest element.
+     */
+    bool addOverwrite(const Type &obj, uint32_t timestamp) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (isMonotonic((StampType) timestamp)) {
+                    Base::addOverwrite(entry(obj, timestamp));
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Find the oldest element with the timestamp at or after the given time.
+     *
+     * @param time Time from which to search.
+     *
+     * @return Index of the element as used by `peek()` and `peekMany()`,
+     *         `numElements()` if there is no such element.
+     */
+    size_t findSince(uint32_t time) const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = lowerBound((StampType) time);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Find the elements with the timestamp at or after `from` and before
+     * `to`. Copy them out with `peekMany(first, dest, num)`.
+     *
+     * @param from       Start of the time window.
+     * @param to         End of the time window, not included.
+     * @param first[out] Index of the oldest element in the window as used by
+     *                   `peek()` and `peekMany()`.
+     *
+     * @return number of elements in the window.
+     */
+    size_t findBetween(uint32_t from, uint32_t to, size_t &first) const {
+        size_t last;
+
+        RB_ATOMIC_START
+            {
+                first = lowerBound((StampType) from);
+                last = lowerBound((StampType) to);
+            }
+        RB_ATOMIC_END
+
+        return (last > first) ? (last - first) : 0;
+    }
+
+
+    /**
+     * Peek at n'th entry in the buffer, see `RingBufCPP::peek()`.
+     *
+     * @param num Index of the entry to peek at, 0 being the oldest one, as
+     *            returned by `findSince()` and `findBetween()`.
+     *
+     * @return A read-only pointer to the num'th entry or `nullptr` if there
+     *         is less entries currently in the buffer than provided index.
+     */
+    const Entry *peek(size_t num) {
+        return Base::peek(num);
+    }
+
+
+    using Base::pull;
+    using Base::pullMany;
+    using Base::peekMany;
+    using Base::drain;
+    using Base::numElements;
+    using Base::isFull;
+    using Base::isEmpty;
+
+protected:
+    typedef typename Base::Index Index;
+
+    /** Half of the range of `StampType`, the maximum span of timestamps. */
+    static const StampType HalfRange = (StampType) ((StampType) ~(StampType) 0 / 2 + 1);
+
+
+    static Entry entry(const Type &obj, uint32_t timestamp) {
+        Entry ret = { (StampType) timestamp, obj };
+        return ret;
+    }
+
+
+    /**
+     * @return timestamp of the num'th element in the buffer, must be called
+     *         from within the critical section.
+     */
+    StampType stampAt(size_t num) const {
+        return this->_buf[Index::add(this->getTail(), num)].timestamp;
+    }
+
+
+    /**
+     * @return true if `timestamp` is not earlier than the timestamp of the
+     *         newest element, must be called from within the critical
+     *         section.
+     */
+    bool isMonotonic(StampType timestamp) const {
+        if (!this->_numElements)
+            return true;
+
+        StampType newest = stampAt(this->_numElements - 1);
+        return (StampType) (timestamp - newest) < HalfRange;
+    }
+
+
+    /**
+     * Binary search for the oldest element with the timestamp not earlier
+     * than `time`. Timestamps are compared as offsets from the oldest
+     * element, which are increasing even if the timestamps wrap around. Must
+     * be called from within the critical section.
+     *
+     * @return index of the element, `_numElements` if there is no such
+     *         element.
+     */
+    size_t lowerBound(StampType time) const {
+        size_t low = 0;
+        size_t high = this->_numElements;
+
+        if (!high)
+            return 0;
+
+        StampType oldest = stampAt(0);
+        StampType offset = (StampType) (time - oldest);
+
+        if (offset >= HalfRange)
+            return 0; // Earlier than the oldest element
+
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+
+            if ((StampType) (stampAt(mid) - oldest) < offset)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        return low;
+    }
+private:
+
+};
+
+#endif
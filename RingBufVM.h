@@ -0,0 +1,371 @@
+#ifndef EM_RINGBUF_VM_CPP_H
+#define EM_RINGBUF_VM_CPP_H
+
+#include "RingBufHelpers.h"
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * A lock-free single-producer/single-consumer ring buffer for Linux hosts,
+ * with the same pages of memory mapped twice back to back. Every element
+ * past the end of the array is also accessible at the start of the array, so
+ * all free space and all stored elements are always a single contiguous
+ * block: bulk operations are one `memcpy()` and the spans returned by
+ * `beginRead()` can be passed directly to parsers or `write()`/`send()`.
+ *
+ * The memory is allocated by `init()`, the capacity is rounded up to fill
+ * whole pages. The threading rules are the same as for RingBufSPSC.
+ *
+ * @tparam Type Type of the elements being stored, must be trivially copyable.
+ */
+template<typename Type>
+class RingBufVM {
+    static_assert(RB_IS_TRIVIALLY_COPYABLE(Type), "Type must be trivially copyable");
+
+public:
+
+    RingBufVM() :
+            _buf(nullptr),
+            _capacity(0),
+            _bytes(0),
+            _head(0),
+            _tail(0) {
+    }
+
+    ~RingBufVM() {
+        release();
+    }
+
+    RingBufVM(const RingBufVM &) = delete;
+    RingBufVM &operator=(const RingBufVM &) = delete;
+
+    /**
+     * Allocate and map the memory of the buffer, releasing the previous one.
+     *
+     * @param minElements Minimum number of elements in this buffer.
+     *
+     * @return true on success, false if the memory could not be mapped.
+     */
+    bool init(size_t minElements) {
+        release();
+
+        long page = sysconf(_SC_PAGESIZE);
+        if ((page <= 0) || !minElements)
+            return false;
+
+        // Both the page size and the element size must divide the size
+        size_t unit = lcm((size_t) page, sizeof(Type));
+        size_t bytes = (minElements * sizeof(Type) + unit - 1) / unit * unit;
+
+        int fd = memfd_create("RingBufVM", MFD_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        uint8_t *base = nullptr;
+
+        if (!ftruncate(fd, (off_t) bytes)) {
+            // Reserve the address range first, then map the pages over it
+            void *area = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (area != MAP_FAILED) {
+                base = (uint8_t *) area;
+
+                if ((mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)
+                     == MAP_FAILED) ||
+                    (mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)
+                     == MAP_FAILED)) {
+                    munmap(area, 2 * bytes);
+                    base = nullptr;
+                }
+            }
+        }
+
+        close(fd); // The mappings keep the memory
+        if (!base)
+            return false;
+
+        _buf = (Type *) base;
+        _bytes = bytes;
+        _capacity = bytes / sizeof(Type);
+        _head = 0;
+        _tail = 0;
+
+        return true;
+    }
+
+
+    /**
+     * Unmap the memory of the buffer, dropping all elements.
+     */
+    void release() {
+        if (_buf)
+            munmap(_buf, 2 * _bytes);
+
+        _buf = nullptr;
+        _capacity = 0;
+        _bytes = 0;
+        _head = 0;
+        _tail = 0;
+    }
+
+
+    /**
+     *  Add an element to the buffer. Must only be called by the producer.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        return addMany(&obj, 1) == 1;
+    }
+
+
+    /**
+     * Remove last element from buffer, and copy it to destination. Must only
+     * be called by the consumer.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be copied.
+     *
+     * @return true on success.
+     */
+    bool pull(Type *dest) {
+        return pullMany(dest, 1) == 1;
+    }
+
+
+    /**
+     * Add multiple elements to the buffer with a single copy. Must only be
+     * called by the producer.
+     *
+     * @param src[in] Array of elements to add.
+     * @param num     Number of elements in the `src` array.
+     *
+     * @return number of elements added, less than `num` if the buffer
+     *         became full.
+     */
+    size_t addMany(const Type *src, size_t num) {
+        size_t free;
+        Type *dest = beginWrite(free);
+
+        if (num > free)
+            num = free;
+        if (num)
+            memcpy(dest, src, num * sizeof(Type));
+
+        return commitWrite(num);
+    }
+
+
+    /**
+     * Remove multiple oldest elements from the buffer and copy them to
+     * destination with a single copy. Must only be called by the consumer.
+     *
+     * @param dest[out] Array to which removed elements will be copied.
+     * @param num       Maximum number of elements to remove, `dest` must be
+     *                  large enough to hold this many elements.
+     *
+     * @return number of elements removed, less than `num` if the buffer
+     *         became empty.
+     */
+    size_t pullMany(Type *dest, size_t num) {
+        size_t used;
+        const Type *src = beginRead(used);
+
+        if (num > used)
+            num = used;
+        if (num)
+            memcpy(dest, src, num * sizeof(Type));
+
+        return commitRead(num);
+    }
+
+
+    /**
+     * Reserve all free space of the buffer for adding elements directly,
+     * e.g. by `read()`. The reserved elements are added to the buffer only by
+     * calling `commitWrite()`. Must only be called by the producer.
+     *
+     * @param contiguous[out] Number of elements which can be written to the
+     *                        returned location, all free space.
+     * @param offset          Number of free elements to skip, for the same
+     *                        interface as RingBufCPP.
+     *
+     * @return A pointer to the first free element (after `offset`) or
+     *         `nullptr` if there are not more than `offset` free elements.
+     */
+    Type *beginWrite(size_t &contiguous, size_t offset = 0) {
+        size_t head = _head;
+        size_t free = _capacity - count(head, RB_LOAD_ACQUIRE(_tail));
+
+        contiguous = (offset < free) ? (free - offset) : 0;
+        return contiguous ? &_buf[position(head) + offset] : nullptr;
+    }
+
+
+    /**
+     * Add elements previously written to the location returned by
+     * `beginWrite()` to the buffer. Must only be called by the producer.
+     *
+     * @param num Number of elements written, at most the number of
+     *            contiguous elements reported by `beginWrite()`.
+     *
+     * @return number of elements added.
+     */
+    size_t commitWrite(size_t num) {
+        size_t head = _head;
+        size_t free = _capacity - count(head, RB_LOAD_ACQUIRE(_tail));
+
+        if (num > free)
+            num = free;
+
+        RB_STORE_RELEASE(_head, advance(head, num));
+
+        return num;
+    }
+
+
+    /**
+     * Access all elements of the buffer directly, without copying them out.
+     * The elements stay in the buffer until they are released by calling
+     * `commitRead()`. Must only be called by the consumer.
+     *
+     * @param contiguous[out] Number of elements which can be read from the
+     *                        returned location, all elements.
+     * @param offset          Index of the first element to access, for the
+     *                        same interface as RingBufCPP.
+     *
+     * @return A pointer to the oldest element (at `offset`) or `nullptr` if
+     *         there are not more than `offset` elements in the buffer.
+     */
+    const Type *beginRead(size_t &contiguous, size_t offset = 0) {
+        size_t tail = _tail;
+        size_t used = count(RB_LOAD_ACQUIRE(_head), tail);
+
+        contiguous = (offset < used) ? (used - offset) : 0;
+        return contiguous ? &_buf[position(tail) + offset] : nullptr;
+    }
+
+
+    /**
+     * Remove elements previously read from the location returned by
+     * `beginRead()` from the buffer. Must only be called by the consumer.
+     *
+     * @param num Number of elements read, at most the number of contiguous
+     *            elements reported by `beginRead()`.
+     *
+     * @return number of elements removed.
+     */
+    size_t commitRead(size_t num) {
+        size_t tail = _tail;
+        size_t used = count(RB_LOAD_ACQUIRE(_head), tail);
+
+        if (num > used)
+            num = used;
+
+        RB_STORE_RELEASE(_tail, advance(tail, num));
+
+        return num;
+    }
+
+
+    /**
+     * @return maximum number of elements in the buffer, 0 before `init()`.
+     */
+    size_t capacity() const {
+        return _capacity;
+    }
+
+
+    /**
+     * @return true if buffer is full.
+     */
+    bool isFull() const {
+        return numElements() >= _capacity;
+    }
+
+
+    /**
+     * @return number of elements currently in buffer.
+     */
+    size_t numElements() const {
+        size_t tail = RB_LOAD_ACQUIRE(_tail);
+        return count(RB_LOAD_ACQUIRE(_head), tail);
+    }
+
+
+    /**
+     * @return true if buffer is empty.
+     */
+    bool isEmpty() const {
+        return !numElements();
+    }
+
+protected:
+    static size_t lcm(size_t a, size_t b) {
+        size_t x = a;
+        size_t y = b;
+
+        while (y) {
+            size_t r = x % y;
+            x = y;
+            y = r;
+        }
+
+        return a / x * b;
+    }
+
+
+    /**
+     * Calculates the number of elements between the two indices in range
+     * `[0, 2 * _capacity)`.
+     *
+     * @return number of elements.
+     */
+    size_t count(size_t head, size_t tail) const {
+        return (head >= tail) ? (head - tail) : (head + 2 * _capacity - tail);
+    }
+
+
+    /**
+     * Converts the index in range `[0, 2 * _capacity)` to the index of the
+     * element in the array.
+     *
+     * @return index of the element in array.
+     */
+    size_t position(size_t index) const {
+        return (index >= _capacity) ? (index - _capacity) : index;
+    }
+
+
+    /**
+     * @return index advanced by `num`, at most `_capacity`, in range
+     *         `[0, 2 * _capacity)`.
+     */
+    size_t advance(size_t index, size_t num) const {
+        index += num;
+        return (index >= 2 * _capacity) ? (index - 2 * _capacity) : index;
+    }
+
+
+    /** Array of `_capacity` elements, mapped twice back to back. */
+    Type *_buf;
+    size_t _capacity;
+    /** Size of one mapping of the array. */
+    size_t _bytes;
+
+    /** Index of the next element to write, see RingBufSPSC. */
+    RB_CACHE_ALIGNED size_t _head;
+    /** Index of the oldest element. */
+    RB_CACHE_ALIGNED size_t _tail;
+private:
+
+};
+
+#endif // __linux__
+
+#endif
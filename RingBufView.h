@@ -0,0 +1,390 @@
+#ifndef EM_RINGBUF_VIEW_CPP_H
+#define EM_RINGBUF_VIEW_CPP_H
+
+#include "RingBufHelpers.h"
+
+/**
+ * A ring (FIFO) buffer with the same concurrency protection as RingBufCPP,
+ * operating on an array provided by the caller. The capacity is set at run
+ * time, so all buffers of the same type share a single copy of the code
+ * regardless of their size, and the array can be placed in a specific memory
+ * region (a `.noinit` section, retained RAM, a shared DMA buffer, ...).
+ *
+ * The array elements must stay constructed for the lifetime of the buffer,
+ * elements are copy-assigned into and out of it.
+ *
+ * @tparam Type Type of the elements being stored.
+ */
+template<typename Type>
+class RingBufView {
+public:
+
+    /**
+     * @param buf      Array used as the storage of the buffer.
+     * @param capacity Number of elements in the `buf` array, which is the
+     *                 maximum number of elements in this buffer.
+     */
+    RingBufView(Type *buf, size_t capacity) :
+            _buf(buf),
+            _capacity(capacity),
+            _head(0),
+            _numElements(0) {
+    }
+
+    /**
+     * @param buf Array used as the storage of the buffer.
+     */
+    template<size_t Capacity>
+    explicit RingBufView(Type (&buf)[Capacity]) :
+            _buf(buf),
+            _capacity(Capacity),
+            _head(0),
+            _numElements(0) {
+    }
+
+    /**
+     *  Add an element to the buffer.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (_numElements < _capacity) {
+                    _buf[_head] = obj;
+                    _head = wrap(_head + 1);
+                    _numElements++;
+
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove last element from buffer, and copy it to destination.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed element
+     *                  will be copied.
+     *
+     * @return true on success.
+     */
+    bool pull(Type *dest) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (_numElements) {
+                    *dest = _buf[getTail()];
+                    _numElements--;
+
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Add multiple elements to the buffer. The elements are copied in at most
+     * two contiguous blocks within a single critical section.
+     *
+     * @param src[in] Array of elements to add.
+     * @param num     Number of elements in the `src` array.
+     *
+     * @return number of elements added, less than `num` if the buffer
+     *         became full.
+     */
+    size_t addMany(const Type *src, size_t num) {
+        RB_ATOMIC_START
+            {
+                size_t free = _capacity - _numElements;
+                if (num > free)
+                    num = free;
+
+                size_t first = _capacity - _head;
+                if (first > num)
+                    first = num;
+
+                Copy::copy(&_buf[_head], src, first);
+                Copy::copy(_buf, src + first, num - first);
+                _head = wrap(_head + num);
+                _numElements += num;
+            }
+        RB_ATOMIC_END
+
+        return num;
+    }
+
+
+    /**
+     * Remove multiple oldest elements from the buffer and copy them to
+     * destination. The elements are copied in at most two contiguous blocks
+     * within a single critical section.
+     *
+     * @param dest[out] Array to which removed elements will be copied.
+     * @param num       Maximum number of elements to remove, `dest` must be
+     *                  large enough to hold this many elements.
+     *
+     * @return number of elements removed, less than `num` if the buffer
+     *         became empty.
+     */
+    size_t pullMany(Type *dest, size_t num) {
+        RB_ATOMIC_START
+            {
+                if (num > _numElements)
+                    num = _numElements;
+
+                size_t tail = getTail();
+                size_t first = _capacity - tail;
+                if (first > num)
+                    first = num;
+
+                Copy::copy(dest, &_buf[tail], first);
+                Copy::copy(dest + first, _buf, num - first);
+                _numElements -= num;
+            }
+        RB_ATOMIC_END
+
+        return num;
+    }
+
+
+    /**
+     * Reserve space for adding elements directly into the underlying array.
+     * The reserved elements are added to the buffer only by calling
+     * `commitWrite()`. No other context may add elements to the buffer while
+     * the reservation is in progress.
+     *
+     * @param contiguous[out] Number of elements which can be written to the
+     *                        returned location.
+     *
+     * @return A pointer to the first free element in the array or `nullptr`
+     *         if the buffer is full.
+     */
+    Type *beginWrite(size_t &contiguous) {
+        Type *ret = nullptr;
+
+        RB_ATOMIC_START
+            {
+                size_t free = _capacity - _numElements;
+
+                contiguous = _capacity - _head;
+                if (contiguous > free)
+                    contiguous = free;
+
+                if (contiguous)
+                    ret = &_buf[_head];
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Add elements previously written to the location returned by
+     * `beginWrite()` to the buffer.
+     *
+     * @param num Number of elements written, at most the number of
+     *            contiguous elements reported by `beginWrite()`.
+     *
+     * @return number of elements added.
+     */
+    size_t commitWrite(size_t num) {
+        RB_ATOMIC_START
+            {
+                size_t free = _capacity - _numElements;
+                if (num > free)
+                    num = free;
+
+                _head = wrap(_head + num);
+                _numElements += num;
+            }
+        RB_ATOMIC_END
+
+        return num;
+    }
+
+
+    /**
+     * Access the oldest elements directly in the underlying array, without
+     * copying them out. The elements stay in the buffer until they are
+     * released by calling `commitRead()`. No other context may remove
+     * elements from the buffer while the reservation is in progress.
+     *
+     * @param contiguous[out] Number of elements which can be read from the
+     *                        returned location.
+     *
+     * @return A pointer to the oldest element in the array or `nullptr` if
+     *         the buffer is empty.
+     */
+    const Type *beginRead(size_t &contiguous) {
+        const Type *ret = nullptr;
+
+        RB_ATOMIC_START
+            {
+                size_t tail = getTail();
+
+                contiguous = _capacity - tail;
+                if (contiguous > _numElements)
+                    contiguous = _numElements;
+
+                if (contiguous)
+                    ret = &_buf[tail];
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove elements previously read from the location returned by
+     * `beginRead()` from the buffer.
+     *
+     * @param num Number of elements read, at most the number of contiguous
+     *            elements reported by `beginRead()`.
+     *
+     * @return number of elements removed.
+     */
+    size_t commitRead(size_t num) {
+        RB_ATOMIC_START
+            {
+                if (num > _numElements)
+                    num = _numElements;
+
+                _numElements -= num;
+            }
+        RB_ATOMIC_END
+
+        return num;
+    }
+
+
+    /**
+     * Peek at n'th element in the buffer.
+     *
+     * @param num Index of the element to peek at. As this is FIFO buffer, the
+     *            oldest element in the buffer is always at index 0 and the
+     *            last added one is at the index `numElements() - 1`.
+     *
+     * @return A pointer to the num'th element or `nullptr` if there is less
+     *         elements currently in the buffer than provided index.
+     */
+    Type *peek(size_t num) {
+        Type *ret = nullptr;
+
+        RB_ATOMIC_START
+            {
+                if (num < _numElements) //make sure not out of bounds
+                    ret = &_buf[wrap(getTail() + num)];
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return maximum number of elements in the buffer.
+     */
+    size_t capacity() const {
+        return _capacity;
+    }
+
+
+    /**
+     * @return true if buffer is full.
+     */
+    bool isFull() const {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _numElements >= _capacity;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return number of elements currently in buffer.
+     */
+    size_t numElements() const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _numElements;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return true if buffer is empty.
+     */
+    bool isEmpty() const {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                ret = !_numElements;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+protected:
+    typedef RingBufCopy<Type> Copy;
+
+
+    /**
+     * Wraps the index around the end of the array.
+     *
+     * @param index Index less than `2 * _capacity`.
+     *
+     * @return index of the element in array.
+     */
+    size_t wrap(size_t index) const {
+        return (index >= _capacity) ? (index - _capacity) : index;
+    }
+
+
+    /**
+     * Calculates the index of the oldest element in the array.
+     *
+     * @return index of the element in array.
+     */
+    size_t getTail() const {
+        return wrap(_head + (_capacity - _numElements));
+    }
+
+
+    /** Underlying array, provided by the caller. */
+    Type *const _buf;
+    const size_t _capacity;
+
+    /** Index of the next element to write. */
+    size_t _head;
+    size_t _numElements;
+private:
+
+};
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef EM_RINGBUF_WAIT_CPP_H
+#define EM_RINGBUF_WAIT_CPP_H
+
+#include "RingBufCPP.h"
+
+/** Timeout value of `RingBufWaitable::waitNotEmpty()` meaning no timeout. */
+#define RB_WAIT_FOREVER 0xFFFFFFFFul
+
+/**
+ * Notifier which does not notify, waiting returns immediately so the consumer
+ * keeps polling the buffer. Used where nothing better is available.
+ */
+struct RingBufPollNotifier {
+    void prepare() {}
+
+    void notify() {}
+
+    void notifyFromISR() {}
+
+    /** @return always true, as if woken immediately. */
+    bool wait(uint32_t timeout) {
+        (void) timeout;
+        return true;
+    }
+};
+
+
+#if defined(__ARM_ARCH) && !defined(__ARM_ARCH_ISA_A64) && (__ARM_ARCH_PROFILE == 'M')
+/**
+ * Notifier for bare-metal Cortex-M, the consumer sleeps in `WFE` until the
+ * producer issues `SEV` or any other event wakes the core. The timeout is not
+ * supported, the wait only returns on an event.
+ */
+struct RingBufWfeNotifier {
+    void prepare() {}
+
+    void notify() {
+        __asm__ __volatile__("dsb\n sev" ::: "memory");
+    }
+
+    void notifyFromISR() {
+        notify();
+    }
+
+    bool wait(uint32_t timeout) {
+        (void) timeout;
+        __asm__ __volatile__("wfe" ::: "memory");
+        return true;
+    }
+};
+#endif
+
+
+#ifdef INC_FREERTOS_H
+/**
+ * Notifier for FreeRTOS, using a direct-to-task notification of the task
+ * waiting for the elements. Include `FreeRTOS.h` and `task.h` before this file.
+ */
+struct RingBufFreeRtosNotifier {
+    RingBufFreeRtosNotifier() :
+            _task(nullptr) {
+    }
+
+    /**
+     * Registers the calling task as the one to notify, before it checks the
+     * number of elements so that no notification is lost in between.
+     */
+    void prepare() {
+        _task = xTaskGetCurrentTaskHandle();
+    }
+
+    void notify() {
+        TaskHandle_t task = _task;
+        if (task)
+            xTaskNotifyGive(task);
+    }
+
+    void notifyFromISR() {
+        BaseType_t woken = pdFALSE;
+        TaskHandle_t task = _task;
+
+        if (task) {
+            vTaskNotifyGiveFromISR(task, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+    }
+
+    /**
+     * @param timeout Timeout in ticks, or RB_WAIT_FOREVER.
+     *
+     * @return true if notified, false on timeout.
+     */
+    bool wait(uint32_t timeout) {
+        TickType_t ticks = (timeout == RB_WAIT_FOREVER) ? portMAX_DELAY : (TickType_t) timeout;
+
+        return ulTaskNotifyTake(pdTRUE, ticks) != 0;
+    }
+
+private:
+    /** Task waiting for the notification. */
+    TaskHandle_t volatile _task;
+};
+#endif
+
+
+/**
+ * RingBufCPP with a consumer able to sleep until there are elements to
+ * process, instead of polling the buffer. Producers signal the consumer only
+ * when the number of elements reaches the notification threshold, so the
+ * consumer can also wait for a batch of elements.
+ *
+ * Elements must only be added through the methods of this class, as the
+ * methods of RingBufCPP do not notify. Use the `...FromISR()` variants in
+ * interrupts. With RB_WATERMARKS the adding methods call the high watermark
+ * callback inside their critical section, with interrupts masked.
+ *
+ * @tparam Type        Type of the elements being stored.
+ * @tparam MaxElements Maximum number of elements in this buffer.
+ * @tparam Notifier    Mechanism used for waiting and notifying, one of
+ *                     RingBufPollNotifier, RingBufWfeNotifier (Cortex-M),
+ *                     RingBufFreeRtosNotifier (FreeRTOS) or a custom class
+ *                     with the same methods. The optional `prepare()` is
+ *                     called by the consumer before it checks the number
+ *                     of elements, a notification given after it must wake
+ *                     the next `wait()`.
+ */
+template<typename Type, size_t MaxElements, typename Notifier = RingBufPollNotifier>
+class RingBufWaitable : public RingBufCPP<Type, MaxElements> {
+    typedef RingBufCPP<Type, MaxElements> Base;
+
+public:
+
+    RingBufWaitable() :
+            _threshold(1) {
+    }
+
+    /**
+     *  Add an element to the buffer, notifying the consumer if the threshold
+     *  is reached.
+     *
+     *  @param obj[in] The element to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        return addMany(&obj, 1) == 1;
+    }
+
+
+    /**
+     *  Same as `add()`, to be called from an interrupt.
+     */
+    bool addFromISR(const Type &obj) {
+        return addManyFromISR(&obj, 1) == 1;
+    }
+
+
+    /**
+     * Add multiple elements to the buffer, notifying the consumer if the
+     * threshold is reached.
+     *
+     * @param src[in] Array of elements to add.
+     * @param num     Number of elements in the `src` array.
+     *
+     * @return number of elements added.
+     */
+    size_t addMany(const Type *src, size_t num) {
+        bool crossed;
+        size_t added = addCounting(src, num, crossed);
+
+        if (crossed)
+            _notifier.notify();
+
+        return added;
+    }
+
+
+    /**
+     *  Same as `addMany()`, to be called from an interrupt.
+     */
+    size_t addManyFromISR(const Type *src, size_t num) {
+        bool crossed;
+        size_t added = addCounting(src, num, crossed);
+
+        if (crossed)
+            _notifier.notifyFromISR();
+
+        return added;
+    }
+
+
+    /**
+     * Wait until there are at least as many elements in the buffer as the
+     * notification threshold. Must only be called by a single consumer.
+     *
+     * @param timeout Timeout passed to the notifier for every wake-up, in its
+     *                units (ticks for FreeRTOS), or RB_WAIT_FOREVER.
+     *
+     * @return true if there are enough elements, false on timeout.
+     */
+    bool waitNotEmpty(uint32_t timeout = RB_WAIT_FOREVER) {
+        prepare(_notifier, 0);
+
+        // Checked again after every wake-up, before blocking again
+        while (this->numElements() < threshold()) {
+            if (!_notifier.wait(timeout))
+                return this->numElements() >= threshold();
+        }
+
+        return true;
+    }
+
+
+    /**
+     * @param threshold Number of elements in the buffer at which producers
+     *                  notify the consumer, between 1 and `MaxElements`.
+     */
+    void setNotifyThreshold(size_t threshold) {
+        if (threshold < 1)
+            threshold = 1;
+        if (threshold > MaxElements)
+            threshold = MaxElements;
+
+        RB_ATOMIC_START
+            {
+                _threshold = threshold;
+            }
+        RB_ATOMIC_END
+    }
+
+
+    /**
+     * @return number of elements in the buffer at which producers notify the
+     *         consumer.
+     */
+    size_t threshold() const {
+        size_t ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _threshold;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+protected:
+    /** Calls `Notifier::prepare()` if the notifier has one. */
+    template<typename N>
+    static auto prepare(N &notifier, int) -> decltype(notifier.prepare(), void()) {
+        notifier.prepare();
+    }
+
+    template<typename N>
+    static void prepare(N &, long) {
+    }
+
+
+    /**
+     * Adds elements to the buffer.
+     *
+     * @param crossed[out] Whether the number of elements reached the
+     *                     threshold with this addition.
+     *
+     * @return number of elements added.
+     */
+    size_t addCounting(const Type *src, size_t num, bool &crossed) {
+        size_t added;
+
+        RB_ATOMIC_START
+            {
+                size_t before = this->_numElements;
+
+                added = Base::addMany(src, num);
+                crossed = (before < _threshold) && (before + added >= _threshold);
+            }
+        RB_ATOMIC_END
+
+        return added;
+    }
+
+
+    Notifier _notifier;
+    size_t _threshold;
+private:
+
+};
+
+#endif
@@ -0,0 +1,310 @@
+#ifndef EM_RINGBUF_WINDOW_CPP_H
+#define EM_RINGBUF_WINDOW_CPP_H
+
+#include "RingBufCPP.h"
+
+/**
+ * A RingBufCPP of numeric samples (e.g. ADC readings) maintaining statistics
+ * of the samples currently in the buffer, for moving average and peak
+ * filters. The sum and the sum of squares are updated in O(1) on every
+ * addition and removal, the minimum and the maximum in amortized O(1) using
+ * monotonic queues of the array indices of the candidates. Queries take a
+ * single critical section instead of a scan of the whole buffer.
+ *
+ * The queues take `2 * MaxElements` additional indices of memory. The
+ * stored samples can not be modified in place, as the statistics would not
+ * match them anymore, so `peek()` only gives read access.
+ *
+ * @tparam Type        Type of the samples being stored, supporting
+ *                     comparison and conversion to `SumType`/`SqSumType`.
+ * @tparam MaxElements Maximum number of samples in this buffer.
+ * @tparam SumType     Type of the sum, large enough for `MaxElements`
+ *                     samples.
+ * @tparam SqSumType   Type of the sum of squares, large enough for
+ *                     `MaxElements` squared samples.
+ */
+template<typename Type, size_t MaxElements, typename SumType = int32_t, typename SqSumType = int64_t>
+class RingBufWindow : protected RingBufCPP<Type, MaxElements> {
+protected:
+    typedef RingBufCPP<Type, MaxElements> Base;
+
+public:
+
+    RingBufWindow() :
+            _sum(0),
+            _sumOfSquares(0) {
+    }
+
+    /**
+     *  Add a sample to the buffer.
+     *
+     *  @param obj[in] The sample to add.
+     *
+     *  @return true on success.
+     */
+    bool add(const Type &obj) {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                size_t index = this->_head;
+
+                ret = Base::add(obj);
+                if (ret)
+                    added(index);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     *  Add a sample to the buffer, removing the oldest sample if the buffer
+     *  is full.
+     *
+     *  @param obj[in] The sample to add.
+     *
+     *  @return true if the oldest sample was removed, false if there was
+     *          room for the sample.
+     */
+    bool addOverwrite(const Type &obj) {
+        bool ret;
+
+        RB_ATOMIC_START
+            {
+                size_t index = this->_head;
+
+                if (this->isFull())
+                    removing(this->getTail());
+
+                ret = Base::addOverwrite(obj);
+                added(index);
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * Remove the oldest sample from buffer, and copy it to destination.
+     *
+     * @param dest[out] Pointer on the allocated object to which removed sample
+     *                  will be copied.
+     *
+     * @return true on success.
+     */
+    bool pull(Type *dest) {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (this->_numElements) {
+                    removing(this->getTail());
+                    ret = Base::pull(dest);
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return sum of the samples in the buffer.
+     */
+    SumType sum() const {
+        SumType ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _sum;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return sum of the squares of the samples in the buffer, e.g. for the
+     *         variance `sumOfSquares() / n - (sum() / n)^2`.
+     */
+    SqSumType sumOfSquares() const {
+        SqSumType ret;
+
+        RB_ATOMIC_START
+            {
+                ret = _sumOfSquares;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @return mean of the samples in the buffer, calculated in `SumType`,
+     *         0 if the buffer is empty.
+     */
+    SumType mean() const {
+        SumType ret = 0;
+
+        RB_ATOMIC_START
+            {
+                if (this->_numElements)
+                    ret = _sum / (SumType) this->_numElements;
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    /**
+     * @param dest[out] Pointer on the allocated object to which the minimum
+     *                  will be copied.
+     *
+     * @return true on success, false if the buffer is empty.
+     */
+    bool minimum(Type *dest) const {
+        return extreme(_min, dest);
+    }
+
+
+    /**
+     * @param dest[out] Pointer on the allocated object to which the maximum
+     *                  will be copied.
+     *
+     * @return true on success, false if the buffer is empty.
+     */
+    bool maximum(Type *dest) const {
+        return extreme(_max, dest);
+    }
+
+
+    /**
+     * Peek at n'th sample in the buffer, see `RingBufCPP::peek()`.
+     *
+     * @param num Index of the sample to peek at, 0 being the oldest one.
+     *
+     * @return A read-only pointer to the num'th sample or `nullptr` if there
+     *         is less samples currently in the buffer than provided index.
+     */
+    const Type *peek(size_t num) {
+        return Base::peek(num);
+    }
+
+
+    using Base::peekMany;
+    using Base::numElements;
+    using Base::isFull;
+    using Base::isEmpty;
+
+protected:
+    typedef typename Base::Index Index;
+    typedef typename Base::IndexType IndexType;
+
+    /**
+     * Queue of array indices of the samples which can still become the
+     * minimum (or maximum) as older samples are removed, from the oldest to
+     * the newest one. The samples are increasing (decreasing) along the
+     * queue, so its first sample is the minimum (maximum).
+     */
+    struct Queue {
+        Queue() :
+                first(0),
+                num(0) {
+        }
+
+        IndexType index[MaxElements];
+        IndexType first;
+        IndexType num;
+    };
+
+
+    /**
+     * Updates the statistics with the sample just added to the array at
+     * `index`, must be called from within the critical section.
+     */
+    void added(size_t index) {
+        const Type &value = this->_buf[index];
+
+        _sum += (SumType) value;
+        _sumOfSquares += (SqSumType) value * (SqSumType) value;
+
+        push(_min, index, false);
+        push(_max, index, true);
+    }
+
+
+    /**
+     * Updates the statistics with the oldest sample at `index` which is
+     * about to be removed, must be called from within the critical section.
+     */
+    void removing(size_t index) {
+        const Type &value = this->_buf[index];
+
+        _sum -= (SumType) value;
+        _sumOfSquares -= (SqSumType) value * (SqSumType) value;
+
+        pop(_min, index);
+        pop(_max, index);
+    }
+
+
+    /**
+     * Adds a new sample to the end of the queue, dropping the samples which
+     * cannot become the extreme anymore.
+     */
+    void push(Queue &queue, size_t index, bool isMax) {
+        const Type &value = this->_buf[index];
+
+        while (queue.num) {
+            const Type &last = this->_buf[queue.index[Index::add(queue.first, queue.num - 1)]];
+
+            if (isMax ? (value < last) : (last < value))
+                break;
+            queue.num--;
+        }
+
+        queue.index[Index::add(queue.first, queue.num)] = (IndexType) index;
+        queue.num++;
+    }
+
+
+    /** Removes the oldest sample from the queue if it is in it. */
+    static void pop(Queue &queue, size_t index) {
+        if (queue.num && (queue.index[queue.first] == index)) {
+            queue.first = (IndexType) Index::add(queue.first, 1);
+            queue.num--;
+        }
+    }
+
+
+    bool extreme(const Queue &queue, Type *dest) const {
+        bool ret = false;
+
+        RB_ATOMIC_START
+            {
+                if (queue.num) {
+                    *dest = this->_buf[queue.index[queue.first]];
+                    ret = true;
+                }
+            }
+        RB_ATOMIC_END
+
+        return ret;
+    }
+
+
+    SumType _sum;
+    SqSumType _sumOfSquares;
+    Queue _min;
+    Queue _max;
+private:
+
+};
+
+#endif
@@ -86,14 +86,12 @@ void isr_event()
 // Print the buffer's contents then empty it
 void print_buf_contents()
 {
-  struct Event e;
-
   Serial.println("\n______Dumping contents of ring buffer_______");
 
-  // Keep looping until pull() returns NULL
-  while (buf.pull(&e))
+  // Process all events in place, they are removed from the buffer at once
+  // when done. Events added by the ISR meanwhile are left for the next dump.
+  buf.drain([](const struct Event &e)
   {
-    //
     Serial.print("Event index: ");
     Serial.println(e.index);
 
@@ -104,7 +102,7 @@ void print_buf_contents()
     Serial.println(e.timestamp);
 
     Serial.println();
-  }
+  });
 
   Serial.println("______Done dumping contents_______");
 
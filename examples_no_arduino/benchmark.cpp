@@ -0,0 +1,187 @@
+/*
+ * Host benchmark of the ring buffer variants, printing CSV to stdout:
+ *
+ *     g++ -O2 -std=c++11 -I.. benchmark.cpp -o benchmark -pthread
+ *     ./benchmark > bench_output.txt
+ *
+ * Columns: benchmark,buffer,element_bytes,capacity,metric,value
+ *
+ * Single-threaded rows report ns/op of the individual operations, the SPSC
+ * rows report throughput of a producer and a consumer thread pinned to
+ * separate cores (if available) and percentiles of the element latency.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+#include "RingBufCPP.h"
+#include "RingBufSPSC.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const size_t Iterations = 1000000;
+
+/** Element of the given size, the SPSC benchmark stores a timestamp in it. */
+template<size_t Size>
+struct Element {
+    uint8_t data[Size];
+};
+
+/** Prevents the compiler from optimizing the benchmarked operation away. */
+template<typename T>
+static void keep(const T &value) {
+    __asm__ __volatile__("" :: "g"(&value) : "memory");
+}
+
+static double nsSince(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+static void row(const char *bench, const char *buffer, size_t bytes, size_t capacity,
+                const char *metric, double value) {
+    printf("%s,%s,%zu,%zu,%s,%.3f\n", bench, buffer, bytes, capacity, metric, value);
+}
+
+template<typename Buffer, size_t Size, size_t Capacity>
+static void benchOps(const char *name) {
+    static Buffer buf;
+    Element<Size> e = {};
+    Clock::time_point start;
+
+    // Half-full buffer so that add/pull pairs wrap around but never fail
+    for (size_t i = 0; i < Capacity / 2; i++)
+        buf.add(e);
+
+    start = Clock::now();
+    for (size_t i = 0; i < Iterations; i++) {
+        e.data[0] = (uint8_t) i;
+        buf.add(e);
+        buf.pull(&e);
+    }
+    row("ops", name, Size, Capacity, "add+pull_ns", nsSince(start, Iterations));
+
+    start = Clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        keep(buf.peek(i & 1));
+    row("ops", name, Size, Capacity, "peek_ns", nsSince(start, Iterations));
+
+    start = Clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        keep(buf.isFull());
+    row("ops", name, Size, Capacity, "isFull_ns", nsSince(start, Iterations));
+
+    start = Clock::now();
+    for (size_t i = 0; i < Iterations; i++)
+        keep(buf.numElements());
+    row("ops", name, Size, Capacity, "numElements_ns", nsSince(start, Iterations));
+
+    Element<Size> batch[Capacity / 2];
+
+    start = Clock::now();
+    for (size_t i = 0; i < Iterations / (Capacity / 2); i++) {
+        buf.addMany(batch, Capacity / 2);
+        buf.pullMany(batch, Capacity / 2);
+    }
+    row("ops", name, Size, Capacity, "addMany+pullMany_ns_per_element",
+        nsSince(start, (Iterations / (Capacity / 2)) * (Capacity / 2)));
+}
+
+static bool pinToCpu(unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) cpu;
+    return false;
+#endif
+}
+
+static double percentile(std::vector<int64_t> &sorted, double p) {
+    return (double) sorted[(size_t) (p * (double) (sorted.size() - 1))];
+}
+
+template<size_t Size, size_t Capacity>
+static void benchSpsc() {
+    static RingBufSPSC<Element<Size>, Capacity> buf;
+    static_assert(Size >= sizeof(int64_t), "Timestamp does not fit in the element");
+    bool pin = std::thread::hardware_concurrency() >= 2;
+    bool producerPinned = false;
+    std::vector<int64_t> latencies(Iterations);
+
+    std::thread producer([pin, &producerPinned] {
+        if (pin)
+            producerPinned = pinToCpu(1);
+
+        Element<Size> e = {};
+        for (size_t i = 0; i < Iterations; i++) {
+            int64_t now = Clock::now().time_since_epoch().count();
+            memcpy(e.data, &now, sizeof(now));
+            while (!buf.add(e))
+                std::this_thread::yield();
+        }
+    });
+
+    bool consumerPinned = pin && pinToCpu(0);
+
+    Clock::time_point start = Clock::now();
+    Element<Size> e;
+    for (size_t i = 0; i < Iterations; i++) {
+        while (!buf.pull(&e))
+            std::this_thread::yield();
+
+        int64_t sent;
+        memcpy(&sent, e.data, sizeof(sent));
+        latencies[i] = Clock::now().time_since_epoch().count() - sent;
+    }
+    double ns = nsSince(start, Iterations);
+    producer.join();
+    bool pinned = producerPinned && consumerPinned;
+
+    // Clock ticks to nanoseconds
+    double tick = 1e9 * Clock::period::num / Clock::period::den;
+    std::sort(latencies.begin(), latencies.end());
+
+    const char *name = pinned ? "RingBufSPSC_pinned" : "RingBufSPSC";
+    row("spsc", name, Size, Capacity, "throughput_Mops", 1e3 / ns);
+    row("spsc", name, Size, Capacity, "throughput_MBps", 1e3 * Size / ns);
+    row("spsc", name, Size, Capacity, "latency_p50_ns", percentile(latencies, 0.50) * tick);
+    row("spsc", name, Size, Capacity, "latency_p99_ns", percentile(latencies, 0.99) * tick);
+    row("spsc", name, Size, Capacity, "latency_p999_ns", percentile(latencies, 0.999) * tick);
+    row("spsc", name, Size, Capacity, "latency_max_ns", (double) latencies.back() * tick);
+}
+
+template<size_t Size, size_t Capacity>
+static void benchAll() {
+    benchOps<RingBufCPP<Element<Size>, Capacity>, Size, Capacity>("RingBufCPP");
+    benchOps<RingBufSPSC<Element<Size>, Capacity>, Size, Capacity>("RingBufSPSC");
+}
+
+template<size_t Size>
+static void benchSize() {
+    benchAll<Size, 64>();  // Power of two
+    benchAll<Size, 100>(); // Non power of two
+}
+
+
+int main() {
+    printf("benchmark,buffer,element_bytes,capacity,metric,value\n");
+
+    benchSize<1>();
+    benchSize<4>();
+    benchSize<16>();
+    benchSize<64>();
+    benchSize<256>();
+
+    benchSpsc<16, 64>();
+    benchSpsc<64, 100>();
+    benchSpsc<256, 64>();
+}
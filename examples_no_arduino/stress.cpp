@@ -0,0 +1,795 @@
+/*
+ * Randomized host stress test of the ring buffer variants, with producer
+ * threads and a timer signal acting as an interrupt which preempts the
+ * consumer at random points:
+ *
+ *     g++ -O1 -g -std=c++11 -fsanitize=thread -I.. stress.cpp -o stress -pthread -lrt
+ *     ./stress [seconds per test]
+ *
+ * Every element carries its source (thread or "ISR") and a sequence number
+ * per source, the consumer checks that every source is received in order
+ * without duplicates and, unless overwriting, without losses. Elements lost
+ * by `addOverwrite()` must match the number of overwrites it reported. With
+ * several consumers (RingBufMPMC) every element must be received exactly
+ * once by any of them, and in order by each of them. The
+ * throughput of every test is printed, the exit code is non-zero on the
+ * first failure. Linux only (POSIX timers).
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <vector>
+#include "RingBufBroadcast.h"
+#include "RingBufCPP.h"
+#include "RingBufMPMC.h"
+#include "RingBufSPSC.h"
+#include "RingBufVM.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const int IrqSignal = SIGALRM;
+
+enum Source : uint8_t {
+    SourceThread,
+    SourceIsr,
+    /** Additional producer threads of RingBufMPMC. */
+    SourceThread2,
+    SourceThread3,
+    Sources
+};
+
+struct Item {
+    uint32_t seq;
+    uint8_t source;
+    /** Derived from the other fields, detects torn copies. */
+    uint32_t check;
+};
+
+static Item makeItem(Source source, uint32_t seq) {
+    Item item;
+
+    item.seq = seq;
+    item.source = source;
+    item.check = (seq * 2654435761u) ^ source;
+    return item;
+}
+
+
+/**
+ * Lock policy emulating interrupt masking between the "ISR" and the thread
+ * it preempts by blocking the signal, plus a spinlock against the other
+ * thread (taken after blocking, so the ISR never spins on its own thread).
+ * Yields while spinning, the holder may be preempted on a single core host.
+ */
+class HostIrqLock {
+public:
+    typedef sigset_t State;
+
+    State lock() const {
+        sigset_t block, old;
+
+        sigemptyset(&block);
+        sigaddset(&block, IrqSignal);
+        pthread_sigmask(SIG_BLOCK, &block, &old);
+        while (__atomic_test_and_set(&_locked, __ATOMIC_ACQUIRE))
+            sched_yield();
+        return old;
+    }
+
+    void unlock(State old) const {
+        __atomic_clear(&_locked, __ATOMIC_RELEASE);
+        pthread_sigmask(SIG_SETMASK, &old, nullptr);
+    }
+
+    static constexpr bool interruptsOnly() {
+        return false;
+    }
+
+private:
+    mutable bool _locked = false;
+};
+
+
+/** xorshift32, separate states for every context. */
+static uint32_t nextRandom(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+
+/* "Interrupt" running in the consumer thread */
+
+static timer_t irqTimer;
+static void (*volatile irqWork)() = nullptr;
+static uint32_t irqRandom = 0x12345678u;
+
+static void armIrq() {
+    struct itimerspec spec = {};
+
+    spec.it_value.tv_nsec = 10000 + nextRandom(irqRandom) % 190000; // 10-200 us
+    timer_settime(irqTimer, 0, &spec, nullptr);
+}
+
+static void onIrq(int) {
+    void (*work)() = irqWork;
+
+    if (work) {
+        work();
+        armIrq();
+    }
+}
+
+static void startIrq(void (*work)()) {
+    irqWork = work;
+    armIrq();
+}
+
+static void stopIrq() {
+    struct itimerspec spec = {};
+
+    irqWork = nullptr;
+    timer_settime(irqTimer, 0, &spec, nullptr);
+}
+
+static void setIrqBlocked(bool blocked) {
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, IrqSignal);
+    pthread_sigmask(blocked ? SIG_BLOCK : SIG_UNBLOCK, &set, nullptr);
+}
+
+
+/** Checks the received elements of every source. */
+class Checker {
+public:
+
+    explicit Checker(bool lossy) :
+            _lossy(lossy),
+            _failed(false),
+            _received(0),
+            _lost(0) {
+        for (int i = 0; i < Sources; i++)
+            _next[i] = 0;
+    }
+
+    void receive(const Item &item) {
+        if (_failed)
+            return;
+
+        if ((item.source >= Sources) || (item.check != ((item.seq * 2654435761u) ^ item.source))) {
+            fail("corrupted element", item);
+            return;
+        }
+
+        uint32_t expected = _next[item.source];
+
+        if (item.seq < expected) {
+            fail("duplicate or reordered element", item);
+            return;
+        }
+        if ((item.seq > expected) && !_lossy) {
+            fail("lost element", item);
+            return;
+        }
+
+        _lost += item.seq - expected;
+        _next[item.source] = item.seq + 1;
+        _received++;
+    }
+
+    bool failed() const {
+        return _failed;
+    }
+
+    uint64_t received() const {
+        return _received;
+    }
+
+    /** Elements skipped between the received ones. */
+    uint64_t lost() const {
+        return _lost;
+    }
+
+    /** Sequence number following the last received element of the source. */
+    uint32_t next(Source source) const {
+        return _next[source];
+    }
+
+private:
+    void fail(const char *what, const Item &item) {
+        printf("FAIL: %s (source %u, seq %u, expected %u)\n",
+               what, item.source, item.seq, item.source < Sources ? _next[item.source] : 0);
+        _failed = true;
+    }
+
+    bool _lossy;
+    bool _failed;
+    uint32_t _next[Sources];
+    uint64_t _received;
+    uint64_t _lost;
+};
+
+
+static double secondsPerTest = 2.0;
+
+static bool report(const char *name, uint64_t received, uint64_t lost, double seconds, bool ok) {
+    printf("%-32s %s  %10llu elements  %8.2f M/s  %llu lost\n", name, ok ? "ok  " : "FAIL",
+           (unsigned long long) received, received / seconds / 1e6, (unsigned long long) lost);
+    return ok;
+}
+
+static bool report(const char *name, const Checker &checker, double seconds, bool ok) {
+    return report(name, checker.received(), checker.lost(), seconds, ok);
+}
+
+static Clock::time_point testEnd(Clock::time_point start) {
+    return start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(secondsPerTest));
+}
+
+
+/* RingBufCPP with the producer thread and the ISR adding elements */
+
+typedef RingBufCPP<Item, 61, HostIrqLock> LockedRing;
+
+static LockedRing lockedRing;
+static bool overwriting;
+static uint32_t isrSeq;
+static uint64_t isrOverwrites;
+
+static void isrAdd() {
+    Item item = makeItem(SourceIsr, isrSeq);
+
+    if (overwriting) {
+        isrOverwrites += lockedRing.addOverwrite(item);
+        isrSeq++;
+    }
+    else if (lockedRing.add(item)) {
+        isrSeq++; // A full buffer drops the interrupt, the same seq is retried
+    }
+}
+
+static bool testLocked(const char *name, bool overwrite) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> threadSeq(0);
+    std::atomic<uint64_t> threadOverwrites(0);
+    Checker checker(overwrite);
+    Item batch[16];
+
+    overwriting = overwrite;
+    isrSeq = 0;
+    isrOverwrites = 0;
+
+    std::thread producer([&] {
+        uint32_t random = 0xCAFEBABEu;
+        uint32_t seq = 0;
+        uint64_t overwrites = 0;
+        Item items[16];
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            uint32_t op = nextRandom(random);
+            uint32_t before = seq;
+
+            if (overwrite) {
+                overwrites += lockedRing.addOverwrite(makeItem(SourceThread, seq++));
+            }
+            else if (op % 4 == 0) {
+                size_t num = 1 + (op >> 8) % 16;
+
+                for (size_t i = 0; i < num; i++)
+                    items[i] = makeItem(SourceThread, seq + i);
+                seq += lockedRing.addMany(items, num);
+            }
+            else if (lockedRing.emplace(makeItem(SourceThread, seq))) {
+                seq++;
+            }
+
+            if ((seq == before) || (op % 64 == 0))
+                std::this_thread::yield(); // Full, let the consumer run
+        }
+
+        threadSeq = seq;
+        threadOverwrites = overwrites;
+    });
+
+    uint32_t random = 0xDEADBEEFu;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = testEnd(start);
+
+    setIrqBlocked(false);
+    startIrq(isrAdd);
+
+    while (!checker.failed()) {
+        bool stopping = Clock::now() >= end;
+        uint32_t op = nextRandom(random);
+        size_t num = 1 + (op >> 8) % 16;
+
+        if (stopping && !stop) {
+            stop = true;
+            producer.join();
+            stopIrq();
+        }
+
+        if (op % 4 == 0 || overwrite) {
+            // Direct access only without overwriting, see beginRead()
+            num = lockedRing.pullMany(batch, num);
+            for (size_t i = 0; i < num; i++)
+                checker.receive(batch[i]);
+        }
+        else if (op % 4 == 1) {
+            Item item;
+            num = lockedRing.pull(&item);
+            if (num)
+                checker.receive(item);
+        }
+        else if (op % 4 == 2) {
+            num = lockedRing.drain([&](const Item &item) { checker.receive(item); }, num);
+        }
+        else {
+            size_t contiguous;
+            const Item *items = lockedRing.beginRead(contiguous);
+
+            num = items ? (contiguous < num ? contiguous : num) : 0;
+            for (size_t i = 0; i < num; i++)
+                checker.receive(items[i]);
+            lockedRing.commitRead(num);
+        }
+
+        if (stopping && !num && lockedRing.isEmpty())
+            break;
+        if (!num)
+            std::this_thread::yield();
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!stop) {
+        stop = true;
+        producer.join();
+        stopIrq();
+    }
+    setIrqBlocked(true);
+
+    // The last elements of a source can be overwritten by the other source
+    uint64_t missing = (uint64_t) (threadSeq - checker.next(SourceThread)) +
+                       (isrSeq - checker.next(SourceIsr));
+    uint64_t overwrites = threadOverwrites + isrOverwrites;
+    bool ok = !checker.failed() &&
+              (overwrite || !missing) &&
+              (checker.lost() + missing == overwrites);
+    if (!checker.failed() && !ok)
+        printf("FAIL: %u/%u thread and %u/%u ISR elements, %llu lost, %llu overwritten\n",
+               checker.next(SourceThread), threadSeq.load(), checker.next(SourceIsr), isrSeq,
+               (unsigned long long) (checker.lost() + missing), (unsigned long long) overwrites);
+
+    return report(name, checker, seconds, ok);
+}
+
+
+/* Lock-free single-producer/single-consumer buffers, the ISR only delays the consumer */
+
+static void isrDelay() {
+    for (volatile uint32_t i = nextRandom(irqRandom) % 2000; i; i--) {
+    }
+}
+
+static size_t drainSome(RingBufSPSC<Item, 64> &ring, Checker &checker, size_t num) {
+    return ring.drain([&](const Item &item) { checker.receive(item); }, num);
+}
+
+#ifdef __linux__
+static size_t drainSome(RingBufVM<Item> &ring, Checker &checker, size_t num) {
+    Item item;
+
+    num = ring.pull(&item); // No drain(), the elements are contiguous anyway
+    if (num)
+        checker.receive(item);
+    return num;
+}
+#endif
+
+template<typename Ring>
+static bool testSpsc(const char *name, Ring &spscRing) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> producedSeq(0);
+    Checker checker(false);
+    Item batch[16];
+
+    std::thread producer([&] {
+        uint32_t random = 0x0BADF00Du;
+        uint32_t seq = 0;
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            uint32_t op = nextRandom(random);
+            uint32_t before = seq;
+            size_t num = 1 + (op >> 8) % 16;
+
+            if (op % 3 == 0) {
+                Item items[16];
+
+                for (size_t i = 0; i < num; i++)
+                    items[i] = makeItem(SourceThread, seq + i);
+                seq += spscRing.addMany(items, num);
+            }
+            else if (op % 3 == 1) {
+                size_t contiguous;
+                Item *items = spscRing.beginWrite(contiguous);
+
+                num = items ? (contiguous < num ? contiguous : num) : 0;
+                for (size_t i = 0; i < num; i++)
+                    items[i] = makeItem(SourceThread, seq + i);
+                seq += spscRing.commitWrite(num);
+            }
+            else if (spscRing.add(makeItem(SourceThread, seq))) {
+                seq++;
+            }
+
+            if ((seq == before) || (op % 64 == 0))
+                std::this_thread::yield(); // Full, let the consumer run
+        }
+
+        producedSeq = seq;
+    });
+
+    uint32_t random = 0xFEEDFACEu;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = testEnd(start);
+
+    setIrqBlocked(false);
+    startIrq(isrDelay);
+
+    while (!checker.failed()) {
+        bool stopping = Clock::now() >= end;
+        uint32_t op = nextRandom(random);
+        size_t num = 1 + (op >> 8) % 16;
+
+        if (stopping && !stop) {
+            stop = true;
+            producer.join();
+            stopIrq();
+        }
+
+        if (op % 3 == 0) {
+            num = spscRing.pullMany(batch, num);
+            for (size_t i = 0; i < num; i++)
+                checker.receive(batch[i]);
+        }
+        else if (op % 3 == 1) {
+            num = drainSome(spscRing, checker, num);
+        }
+        else {
+            size_t contiguous;
+            const Item *items = spscRing.beginRead(contiguous);
+
+            num = items ? (contiguous < num ? contiguous : num) : 0;
+            for (size_t i = 0; i < num; i++)
+                checker.receive(items[i]);
+            spscRing.commitRead(num);
+        }
+
+        if (stopping && !num && spscRing.isEmpty())
+            break;
+        if (!num)
+            std::this_thread::yield();
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!stop) {
+        stop = true;
+        producer.join();
+        stopIrq();
+    }
+    setIrqBlocked(true);
+
+    bool ok = !checker.failed() && (checker.next(SourceThread) == producedSeq);
+    if (!checker.failed() && !ok)
+        printf("FAIL: received %u of %u elements\n", checker.next(SourceThread), producedSeq.load());
+
+    return report(name, checker, seconds, ok);
+}
+
+
+/* Lock-free RingBufMPMC with several producer and consumer threads and the ISR adding */
+
+/** Marks received sequence numbers of every source, to detect duplicates. */
+class SeenSet {
+public:
+    /** Limit of the elements of every source, producers stop there. */
+    static const uint32_t MaxSeq = 1u << 24;
+
+    SeenSet() :
+            _bits(Sources * (MaxSeq / 32)) {
+    }
+
+    /** @return false if the element was already received. */
+    bool mark(const Item &item) {
+        uint32_t index = item.source * MaxSeq + item.seq;
+        uint32_t bit = 1u << (index % 32);
+
+        return !(_bits[index / 32].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+private:
+    std::vector<std::atomic<uint32_t>> _bits;
+};
+
+static RingBufMPMC<Item, 64> mpmcRing;
+
+static void isrAddMpmc() {
+    if ((isrSeq < SeenSet::MaxSeq) && mpmcRing.add(makeItem(SourceIsr, isrSeq)))
+        isrSeq++;
+}
+
+/**
+ * Consumes elements of the MPMC buffer, checking the order of every source
+ * with its own checker and duplicates across all consumers.
+ *
+ * @return number of elements consumed.
+ */
+static size_t consumeMpmc(Checker &checker, SeenSet &seen, bool &duplicate) {
+    Item item;
+
+    if (!mpmcRing.pull(&item))
+        return 0;
+
+    checker.receive(item);
+    if ((item.source >= Sources) || (item.seq >= SeenSet::MaxSeq) || !seen.mark(item)) {
+        printf("FAIL: duplicate element (source %u, seq %u)\n", item.source, item.seq);
+        duplicate = true;
+    }
+    return 1;
+}
+
+static bool testMpmc(const char *name) {
+    static const Source producerSources[] = { SourceThread, SourceThread2, SourceThread3 };
+    static const size_t NumProducers = sizeof(producerSources) / sizeof(producerSources[0]);
+
+    std::atomic<bool> stop(false);
+    std::atomic<bool> producersDone(false);
+    std::atomic<uint32_t> producedSeq[Sources];
+    SeenSet seen;
+    Checker mainChecker(true);
+    Checker threadChecker(true);
+    bool mainDuplicate = false;
+    bool threadDuplicate = false;
+    std::vector<std::thread> producers;
+
+    for (int i = 0; i < Sources; i++)
+        producedSeq[i] = 0;
+    isrSeq = 0;
+
+    for (size_t p = 0; p < NumProducers; p++) {
+        producers.emplace_back([&, p] {
+            Source source = producerSources[p];
+            uint32_t random = 0x9E3779B9u * (uint32_t) (p + 1);
+            uint32_t seq = 0;
+
+            while (!stop.load(std::memory_order_relaxed) && (seq < SeenSet::MaxSeq)) {
+                uint32_t op = nextRandom(random);
+
+                if (mpmcRing.emplace(makeItem(source, seq)))
+                    seq++;
+                else
+                    std::this_thread::yield(); // Full, let the consumers run
+
+                if (op % 64 == 0)
+                    std::this_thread::yield();
+            }
+
+            producedSeq[source] = seq;
+        });
+    }
+
+    // The second consumer, the main thread is the first one
+    std::thread consumer([&] {
+        while (!threadChecker.failed() && !threadDuplicate) {
+            bool done = producersDone.load();
+
+            if (!consumeMpmc(threadChecker, seen, threadDuplicate)) {
+                if (done)
+                    break;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = testEnd(start);
+
+    setIrqBlocked(false);
+    startIrq(isrAddMpmc);
+
+    while (!mainChecker.failed() && !mainDuplicate) {
+        bool stopping = Clock::now() >= end;
+
+        if (stopping && !stop) {
+            stop = true;
+            for (size_t p = 0; p < NumProducers; p++)
+                producers[p].join();
+            stopIrq();
+            producersDone = true;
+        }
+
+        if (!consumeMpmc(mainChecker, seen, mainDuplicate)) {
+            if (stopping)
+                break;
+            std::this_thread::yield();
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!stop) {
+        stop = true;
+        for (size_t p = 0; p < NumProducers; p++)
+            producers[p].join();
+        stopIrq();
+        producersDone = true;
+    }
+    consumer.join();
+    setIrqBlocked(true);
+    producedSeq[SourceIsr] = isrSeq;
+
+    uint64_t produced = 0;
+    for (int i = 0; i < Sources; i++)
+        produced += producedSeq[i];
+
+    uint64_t received = mainChecker.received() + threadChecker.received();
+    bool ok = !mainChecker.failed() && !threadChecker.failed() &&
+              !mainDuplicate && !threadDuplicate &&
+              (received == produced) && mpmcRing.isEmpty();
+    if (!mainChecker.failed() && !threadChecker.failed() && !ok)
+        printf("FAIL: received %llu of %llu elements\n",
+               (unsigned long long) received, (unsigned long long) produced);
+
+    // Skipped sequence numbers of a consumer were received by the other one
+    return report(name, received, (produced > received) ? produced - received : 0, seconds, ok);
+}
+
+
+/* RingBufBroadcast with the producer thread and the ISR adding, two readers in the consumer */
+
+static RingBufBroadcast<Item, 61, 2, HostIrqLock> broadcastRing;
+
+static void isrAddBroadcast() {
+    if (broadcastRing.add(makeItem(SourceIsr, isrSeq)))
+        isrSeq++;
+}
+
+static bool testBroadcast(const char *name) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> threadSeq(0);
+    Checker checkers[2] = { Checker(false), Checker(false) };
+    Item batch[16];
+
+    isrSeq = 0;
+
+    std::thread producer([&] {
+        uint32_t random = 0xB16B00B5u;
+        uint32_t seq = 0;
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            uint32_t op = nextRandom(random);
+
+            if (broadcastRing.add(makeItem(SourceThread, seq)))
+                seq++;
+            else
+                std::this_thread::yield(); // Full, let the readers run
+
+            if (op % 64 == 0)
+                std::this_thread::yield();
+        }
+
+        threadSeq = seq;
+    });
+
+    uint32_t random = 0xABCDEF01u;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = testEnd(start);
+
+    setIrqBlocked(false);
+    startIrq(isrAddBroadcast);
+
+    while (!checkers[0].failed() && !checkers[1].failed()) {
+        bool stopping = Clock::now() >= end;
+        uint32_t op = nextRandom(random);
+        size_t reader = op & 1;
+        size_t num = 1 + (op >> 8) % 16;
+
+        if (stopping && !stop) {
+            stop = true;
+            producer.join();
+            stopIrq();
+        }
+
+        if (op % 4 < 2) {
+            num = broadcastRing.pullMany(reader, batch, num);
+            for (size_t i = 0; i < num; i++)
+                checkers[reader].receive(batch[i]);
+        }
+        else {
+            Item item;
+            num = broadcastRing.pull(reader, &item);
+            if (num)
+                checkers[reader].receive(item);
+        }
+
+        if (stopping && broadcastRing.isEmpty(0) && broadcastRing.isEmpty(1))
+            break;
+        if (!num)
+            std::this_thread::yield();
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!stop) {
+        stop = true;
+        producer.join();
+        stopIrq();
+    }
+    setIrqBlocked(true);
+
+    bool ok = !checkers[0].failed() && !checkers[1].failed();
+    for (size_t r = 0; r < 2; r++) {
+        if (ok && ((checkers[r].next(SourceThread) != threadSeq) ||
+                   (checkers[r].next(SourceIsr) != isrSeq) || broadcastRing.lost(r))) {
+            printf("FAIL: reader %u received %u/%u thread and %u/%u ISR elements\n", (unsigned) r,
+                   checkers[r].next(SourceThread), threadSeq.load(), checkers[r].next(SourceIsr), isrSeq);
+            ok = false;
+        }
+    }
+
+    return report(name, checkers[0].received() + checkers[1].received(), 0, seconds, ok);
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc > 1)
+        secondsPerTest = atof(argv[1]);
+
+    // Only the consumer (main) thread unblocks the signal, when testing
+    setIrqBlocked(true);
+
+    struct sigaction action = {};
+    action.sa_handler = onIrq;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(IrqSignal, &action, nullptr);
+
+    struct sigevent event = {};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = IrqSignal;
+    if (timer_create(CLOCK_MONOTONIC, &event, &irqTimer)) {
+        perror("timer_create");
+        return 2;
+    }
+
+    static RingBufSPSC<Item, 64> spscRing;
+    static RingBufVM<Item> vmRing;
+
+    if (!vmRing.init(64)) {
+        perror("RingBufVM");
+        return 2;
+    }
+
+    bool ok = testLocked("RingBufCPP add/pull", false) &&
+              testLocked("RingBufCPP addOverwrite/pull", true) &&
+              testSpsc("RingBufSPSC", spscRing) &&
+              testSpsc("RingBufVM", vmRing) &&
+              testMpmc("RingBufMPMC") &&
+              testBroadcast("RingBufBroadcast");
+
+    timer_delete(irqTimer);
+    return ok ? 0 : 1;
+}
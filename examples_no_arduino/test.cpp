@@ -20,9 +20,8 @@ int main() {
         }
     }
 
-    while (!q.isEmpty()) {
-        int pulled;
-        q.pull(&pulled);
+    int pulled;
+    while (q.pull(&pulled)) {
         printf("Got %d\n", pulled);
     }
 }